@@ -0,0 +1,153 @@
+// Throughput of translateBatch() and the column kernel (AVX2 and scalar)
+// versus one translateAddress() call per address on the same trace, once
+// with every page resident and once with the working set at four times
+// memory, so faults and evictions are part of what is timed. The AVX2
+// column needs -DVMSIM_AVX2=ON; otherwise it runs the scalar lanes again.
+//
+//   cmake --build build --target bench_batch
+//   ./bench_batch [numAddresses]   (default 10000000)
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+#include "vmsim.hpp"
+#include "translate_simd.hpp"
+
+const int NUM_FRAMES = 256;
+const int PAGE_SIZE = 4096;
+const int NUM_SEGMENTS = 4;
+const int DIR_SIZE = 4;
+const int TABLE_SIZE = 16;
+const size_t CHUNK = 4096;
+const uint64_t SEED = 1;
+
+void setupSegments(SegmentTable& st) {
+    for (int i = 0; i < NUM_SEGMENTS; ++i) {
+        st.addSegment(i, 0, DIR_SIZE, READ_WRITE, DIR_SIZE, TABLE_SIZE);
+    }
+}
+
+// Runs of sequential pages inside one page table, like the batch traces.
+std::vector<LogicalAddress> makeTrace(size_t num) {
+    Rng gen(42);
+    std::vector<LogicalAddress> trace;
+    trace.reserve(num);
+    while (trace.size() < num) {
+        int segNum = gen() % NUM_SEGMENTS;
+        int pageDir = gen() % DIR_SIZE;
+        int pageNum = gen() % TABLE_SIZE;
+        int runLength = 1 + gen() % 64;
+        for (int k = 0; k < runLength && trace.size() < num; ++k) {
+            int offset = gen() % PAGE_SIZE;
+            Protection access = (gen() % 4 == 0) ? READ_WRITE : READ_ONLY;
+            trace.push_back({segNum, pageDir, (pageNum + k / 8) % TABLE_SIZE, offset, access});
+        }
+    }
+    return trace;
+}
+
+// Every translation path over the same trace with numFrames frames; false
+// if any of them gives different results
+bool runCase(const char* name, const std::vector<LogicalAddress>& trace, int numFrames) {
+    std::cout << name << ": " << trace.size() << " addresses, " << numFrames << " frames\n";
+
+    long scalarChecksum = 0;
+    double scalarSecs;
+    {
+        SegmentTable st(numFrames, PAGE_SIZE, LRU, SEED);
+        setupSegments(st);
+
+        auto start = std::chrono::steady_clock::now();
+        for (const LogicalAddress& a : trace) {
+            int latency;
+            std::string fault;
+            int addr = st.translateAddress(a.segNum, a.pageDir, a.pageNum, a.offset, a.access, latency, fault);
+            scalarChecksum += addr + latency;
+        }
+        scalarSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  evictions: " << st.physMem->evictions << "\n";
+    }
+
+    long batchChecksum = 0;
+    double batchSecs;
+    {
+        SegmentTable st(numFrames, PAGE_SIZE, LRU, SEED);
+        setupSegments(st);
+        std::vector<TranslationResult> results(CHUNK);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < trace.size(); i += CHUNK) {
+            size_t n = std::min(CHUNK, trace.size() - i);
+            st.translateBatch(std::span<const LogicalAddress>(trace.data() + i, n),
+                              std::span<TranslationResult>(results.data(), n));
+            for (size_t k = 0; k < n; ++k) {
+                batchChecksum += results[k].physical_address + results[k].latency;
+            }
+        }
+        batchSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // same trace as structure-of-arrays columns
+    std::vector<int32_t> segCol, dirCol, pageCol, offsetCol, accessCol;
+    for (const LogicalAddress& a : trace) {
+        segCol.push_back(a.segNum);
+        dirCol.push_back(a.pageDir);
+        pageCol.push_back(a.pageNum);
+        offsetCol.push_back(a.offset);
+        accessCol.push_back(a.access);
+    }
+
+    auto runColumns = [&](bool allowSimd, long& checksum) {
+        SegmentTable st(numFrames, PAGE_SIZE, LRU, SEED);
+        setupSegments(st);
+        TranslationView view(st);
+        std::vector<TranslationResult> results(CHUNK);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < trace.size(); i += CHUNK) {
+            size_t n = std::min(CHUNK, trace.size() - i);
+            AddressColumns cols{{segCol.data() + i, n}, {dirCol.data() + i, n}, {pageCol.data() + i, n},
+                                {offsetCol.data() + i, n}, {accessCol.data() + i, n}};
+            translateColumns(st, view, cols, std::span<TranslationResult>(results.data(), n), allowSimd);
+            for (size_t k = 0; k < n; ++k) {
+                checksum += results[k].physical_address + results[k].latency;
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    long columnsChecksum = 0, simdChecksum = 0;
+    double columnsSecs = runColumns(false, columnsChecksum);
+    double simdSecs = runColumns(true, simdChecksum);
+
+    std::cout << "  translateAddress: " << scalarSecs << " s, "
+              << trace.size() / scalarSecs / 1e6 << " M addr/s\n";
+    std::cout << "  translateBatch:   " << batchSecs << " s, "
+              << trace.size() / batchSecs / 1e6 << " M addr/s\n";
+    std::cout << "  Columns (scalar): " << columnsSecs << " s, "
+              << trace.size() / columnsSecs / 1e6 << " M addr/s\n";
+    std::cout << "  Columns (" << (avx2Available() ? "AVX2" : "AVX2 off, scalar") << "): " << simdSecs << " s, "
+              << trace.size() / simdSecs / 1e6 << " M addr/s\n";
+    std::cout << "  Speedup (batch): " << scalarSecs / batchSecs << "x\n";
+    std::cout << "  Speedup (columns): " << scalarSecs / simdSecs << "x\n";
+
+    if (scalarChecksum != batchChecksum || scalarChecksum != columnsChecksum
+        || scalarChecksum != simdChecksum) {
+        std::cout << "Error: batch results differ from per-address results\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t num = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    verbose = false;
+
+    std::vector<LogicalAddress> trace = makeTrace(num);
+    bool same = runCase("Resident", trace, NUM_FRAMES);
+    same &= runCase("Over memory", trace, NUM_FRAMES / 4);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,479 @@
+// Micro-benchmarks for the translation core (Google Benchmark).
+//
+//   cmake --build build --target bench_core   (needs Google Benchmark)
+//   ./bench_core [--benchmark_filter=...]
+//
+// Every benchmark reports ns/op (the library's Time column) and allocs/op,
+// counted by the replacement operator new below.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include "vmsim.hpp"
+#include "trace.hpp"
+#include "snapshot.hpp"
+#include "fault_io.hpp"
+#include "workload.hpp"
+
+static std::atomic<long> allocation_count{0};
+
+// Every form is replaced, so each allocation is counted and every pointer
+// goes back to the allocator that made it; the nothrow forms forward here.
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    std::size_t a = (std::size_t)align;
+    // aligned_alloc wants a size that is a multiple of the alignment
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return ::operator new(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// Reports allocations made since construction, per iteration, leaving out
+// anything allocated between pause() and resume().
+class AllocationCounter {
+public:
+    explicit AllocationCounter(benchmark::State& s) : state(s), start(allocation_count.load()) {}
+    ~AllocationCounter() {
+        state.counters["allocs/op"] = benchmark::Counter((double)(allocation_count.load() - start - excluded),
+                                                         benchmark::Counter::kAvgIterations);
+    }
+
+    void pause() {
+        state.PauseTiming();
+        pausedAt = allocation_count.load();
+    }
+
+    void resume() {
+        excluded += allocation_count.load() - pausedAt;
+        state.ResumeTiming();
+    }
+
+private:
+    benchmark::State& state;
+    long start;
+    long pausedAt = 0;
+    long excluded = 0;
+};
+
+struct Shape {
+    int segments;
+    int dirSize;
+    int tableSize;
+};
+
+void addSegments(SegmentTable& st, const Shape& shape) {
+    for (int i = 0; i < shape.segments; ++i) {
+        st.addSegment(i, 0, shape.dirSize, READ_WRITE, shape.dirSize, shape.tableSize);
+    }
+}
+
+// Every page of every table in order, read-only so protection never faults.
+std::vector<LogicalAddress> allPages(const Shape& shape) {
+    std::vector<LogicalAddress> addrs;
+    for (int s = 0; s < shape.segments; ++s)
+        for (int d = 0; d < shape.dirSize; ++d)
+            for (int p = 0; p < shape.tableSize; ++p)
+                addrs.push_back({s, d, p, 7, READ_ONLY});
+    return addrs;
+}
+
+Shape shapeFrom(const benchmark::State& state) {
+    return {(int)state.range(1), (int)state.range(2), (int)state.range(3)};
+}
+
+// Args: frames, segments, dirSize, tableSize
+void shapeArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"frames", "segs", "dirs", "pages"});
+    for (int frames : {64, 1024}) {
+        b->Args({frames, 4, 4, 16});
+        b->Args({frames, 64, 8, 64});
+    }
+}
+
+void BM_TranslateHit(benchmark::State& state) {
+    Shape shape = shapeFrom(state);
+    SegmentTable st((int)state.range(0), 4096, LRU);
+    addSegments(st, shape);
+    std::vector<LogicalAddress> addrs = allPages(shape);
+    addrs.resize(std::min<size_t>(addrs.size(), st.physMem->num_frames));
+
+    int latency;
+    std::string fault;
+    for (const LogicalAddress& a : addrs) {
+        st.translateAddress(a.segNum, a.pageDir, a.pageNum, a.offset, a.access, latency, fault);
+    }
+
+    AllocationCounter allocs(state);
+    size_t i = 0;
+    for (auto _ : state) {
+        const LogicalAddress& a = addrs[i];
+        benchmark::DoNotOptimize(st.translateAddress(a.segNum, a.pageDir, a.pageNum, a.offset, a.access, latency, fault));
+        if (++i == addrs.size()) i = 0;
+    }
+}
+BENCHMARK(BM_TranslateHit)->Apply(shapeArgs);
+
+void BM_TranslateFaultFreeFrame(benchmark::State& state) {
+    Shape shape = shapeFrom(state);
+    int frames = (int)state.range(0);
+    std::vector<LogicalAddress> addrs = allPages(shape);
+    size_t faultsPerTable = std::min<size_t>(addrs.size(), frames);
+
+    auto* st = new SegmentTable(frames, 4096, FIFO);
+    addSegments(*st, shape);
+    int latency;
+    std::string fault;
+    size_t i = 0;
+
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        if (i == faultsPerTable) {
+            // memory is full: start over with an empty table
+            allocs.pause();
+            delete st;
+            st = new SegmentTable(frames, 4096, FIFO);
+            addSegments(*st, shape);
+            i = 0;
+            allocs.resume();
+        }
+        const LogicalAddress& a = addrs[i++];
+        benchmark::DoNotOptimize(st->translateAddress(a.segNum, a.pageDir, a.pageNum, a.offset, a.access, latency, fault));
+    }
+    delete st;
+}
+BENCHMARK(BM_TranslateFaultFreeFrame)->Apply(shapeArgs);
+
+// Shapes with more pages than frames
+void evictArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"frames", "segs", "dirs", "pages"});
+    b->Args({64, 4, 4, 16});
+    b->Args({64, 64, 8, 64});
+    b->Args({1024, 64, 8, 64});
+}
+
+// Cycling over more pages than frames misses on every access under both
+// policies, so each iteration is a fault plus an eviction.
+template <ReplacementAlgorithm ALGO>
+void BM_TranslateFaultEvict(benchmark::State& state) {
+    Shape shape = shapeFrom(state);
+    SegmentTable st((int)state.range(0), 4096, ALGO);
+    addSegments(st, shape);
+    std::vector<LogicalAddress> addrs = allPages(shape);
+    if ((int)addrs.size() <= st.physMem->num_frames) {
+        state.SkipWithError("shape fits in memory");
+        return;
+    }
+
+    int latency;
+    std::string fault;
+    size_t i = 0;
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        const LogicalAddress& a = addrs[i];
+        benchmark::DoNotOptimize(st.translateAddress(a.segNum, a.pageDir, a.pageNum, a.offset, a.access, latency, fault));
+        if (++i == addrs.size()) i = 0;
+    }
+}
+BENCHMARK_TEMPLATE(BM_TranslateFaultEvict, FIFO)->Apply(evictArgs);
+BENCHMARK_TEMPLATE(BM_TranslateFaultEvict, LRU)->Apply(evictArgs);
+
+void BM_AllocateFrame(benchmark::State& state) {
+    int frames = (int)state.range(0);
+    auto* mem = new PhysicalMemory(frames, FIFO);
+    int allocated = 0;
+
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        if (allocated == frames) {
+            allocs.pause();
+            delete mem;
+            mem = new PhysicalMemory(frames, FIFO);
+            allocated = 0;
+            allocs.resume();
+        }
+        benchmark::DoNotOptimize(mem->allocateFrame());
+        allocated++;
+    }
+    delete mem;
+}
+BENCHMARK(BM_AllocateFrame)->Arg(64)->Arg(1024)->Arg(16384);
+
+void BM_Utilization(benchmark::State& state) {
+    int frames = (int)state.range(0);
+    PhysicalMemory mem(frames, FIFO);
+    for (int i = 0; i < frames / 2; ++i) mem.allocateFrame();
+
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mem.utilization());
+    }
+}
+BENCHMARK(BM_Utilization)->Arg(64)->Arg(1024)->Arg(16384);
+
+// Parsing cost of the batch-file front end; ns/op is per file, ns/line per line.
+void BM_BatchFileParse(benchmark::State& state) {
+    size_t lines = state.range(0);
+    std::string path = "bench_core_trace.txt";
+    {
+        std::ofstream out(path);
+        Rng gen(1);
+        out << "# seg pageDir pageNum offset access\n";
+        for (size_t i = 0; i < lines; ++i) {
+            out << gen.uniform(4) << " " << gen.uniform(4) << " " << gen.uniform(16) << " "
+                << gen.uniform(4096) << " " << gen.uniform(2) << "\n";
+        }
+    }
+
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        Trace trace;
+        trace.loadText(path);
+        benchmark::DoNotOptimize(trace.size());
+    }
+    state.SetItemsProcessed(state.iterations() * lines);
+    state.counters["ns/line"] = benchmark::Counter((double)(state.iterations() * lines),
+                                                   benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_BatchFileParse)->Arg(1000)->Arg(100000);
+
+// Warm state the slow way: build the tables and fault every page in.
+void BM_WarmUpReplay(benchmark::State& state) {
+    Shape shape = shapeFrom(state);
+    std::vector<LogicalAddress> addrs = allPages(shape);
+    std::vector<TranslationResult> results(addrs.size());
+
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        SegmentTable st((int)state.range(0), 4096, LRU);
+        addSegments(st, shape);
+        st.translateBatch(addrs, results);
+        benchmark::DoNotOptimize(st.physMem->time);
+    }
+}
+BENCHMARK(BM_WarmUpReplay)->Apply(shapeArgs)->Unit(benchmark::kMicrosecond);
+
+// The same warm state restored from a snapshot of it.
+void BM_SnapshotRestore(benchmark::State& state) {
+    Shape shape = shapeFrom(state);
+    std::string path = "bench_core_state.snap";
+    {
+        SegmentTable st((int)state.range(0), 4096, LRU);
+        addSegments(st, shape);
+        std::vector<LogicalAddress> addrs = allPages(shape);
+        std::vector<TranslationResult> results(addrs.size());
+        st.translateBatch(addrs, results);
+        saveSnapshot(st, path);
+    }
+
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        SegmentTable st(1, 4096, LRU);
+        if (!restoreSnapshot(st, path)) {
+            state.SkipWithError("restore failed");
+            break;
+        }
+        benchmark::DoNotOptimize(st.physMem->time);
+    }
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_SnapshotRestore)->Apply(shapeArgs)->Unit(benchmark::kMicrosecond);
+
+// Resident set size in KiB, from /proc/self/statm (0 if unavailable)
+static long residentKiB() {
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Building and tearing down a table of many small segments; rss_KiB is
+// the resident growth while one such table is alive.
+void BM_SegmentSetup(benchmark::State& state) {
+    int segments = (int)state.range(0);
+    auto build = [&](SegmentTable& st) {
+        for (int s = 0; s < segments; ++s) st.addSegment(s, 0, 4, READ_WRITE, 4, 64);
+    };
+
+    malloc_trim(0); // earlier runs' freed memory would otherwise be reused unseen
+    long before = residentKiB();
+    {
+        SegmentTable st(64, 4096, LRU);
+        build(st);
+        state.counters["rss_KiB"] = (double)(residentKiB() - before);
+    }
+
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        SegmentTable st(64, 4096, LRU);
+        build(st);
+        benchmark::DoNotOptimize(st.segment_directories.size());
+    }
+    state.SetItemsProcessed(state.iterations() * segments);
+}
+BENCHMARK(BM_SegmentSetup)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// Fault cost with a swap file behind memory: 1024 pages cycling through 64
+// frames, read in page order (arg 0) or at random (arg 1), so almost every
+// access evicts one page and reads another back. Once every page has been
+// written out once, the evicted pages are clean and writes drop to zero.
+template <SwapLayout L>
+void BM_SwapFault(benchmark::State& state) {
+    std::string path = "bench_core_swap.bin";
+    BackingStore store(path, 64, 4096, L);
+    SegmentTable st(64, 4096, FIFO);
+    st.physMem->store = &store;
+    st.addSegment(0, 0, 16, READ_WRITE, 16, 64);
+
+    std::vector<LogicalAddress> addrs;
+    Rng gen(1);
+    for (int i = 0; i < 1024; ++i) {
+        int page = state.range(0) ? (int)gen.uniform(1024) : i;
+        addrs.push_back({0, page / 64, page % 64, 0, READ_ONLY});
+    }
+
+    AllocationCounter allocs(state);
+    size_t i = 0;
+    for (auto _ : state) {
+        const LogicalAddress& a = addrs[i++ & 1023];
+        int latency;
+        benchmark::DoNotOptimize(st.translateAddress(a.segNum, a.pageDir, a.pageNum, a.offset, a.access, latency));
+    }
+    state.counters["reads"] = benchmark::Counter((double)store.swap_ins, benchmark::Counter::kAvgIterations);
+    state.counters["writes"] = benchmark::Counter((double)store.swap_outs, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_TEMPLATE(BM_SwapFault, SWAP_PACKED)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_SwapFault, SWAP_BY_TABLE)->Arg(0)->Arg(1);
+
+// The random fault stream of BM_SwapFault with page-ins in flight through
+// io_uring (or the pread thread pool) at the given queue depth, to compare
+// against synchronous servicing above.
+template <bool Uring>
+void BM_AsyncSwapFault(benchmark::State& state) {
+    int depth = (int)state.range(0);
+    std::unique_ptr<FaultIo> io = makeFaultIo(depth, Uring);
+    if (Uring && std::string(io->name()) != "io_uring") {
+        state.SkipWithError("io_uring unavailable");
+        return;
+    }
+    std::string path = "bench_core_swap.bin";
+    BackingStore store(path, 64, 4096, SWAP_PACKED);
+    store.useAsyncReads(io.get(), depth);
+    SegmentTable st(64, 4096, FIFO);
+    st.physMem->store = &store;
+    st.addSegment(0, 0, 16, READ_WRITE, 16, 64);
+
+    std::vector<LogicalAddress> addrs;
+    Rng gen(1);
+    for (int i = 0; i < 1024; ++i) {
+        int page = (int)gen.uniform(1024);
+        addrs.push_back({0, page / 64, page % 64, 0, READ_ONLY});
+    }
+
+    AllocationCounter allocs(state);
+    size_t i = 0;
+    for (auto _ : state) {
+        const LogicalAddress& a = addrs[i++ & 1023];
+        int latency;
+        benchmark::DoNotOptimize(st.translateAddress(a.segNum, a.pageDir, a.pageNum, a.offset, a.access, latency));
+    }
+    store.drain();
+    state.SetItemsProcessed(state.iterations());
+    state.counters["max_in_flight"] = store.max_in_flight;
+}
+BENCHMARK_TEMPLATE(BM_AsyncSwapFault, true)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+BENCHMARK_TEMPLATE(BM_AsyncSwapFault, false)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// The random fault stream of BM_SwapFault with a compressed tier of the
+// given KiB in front of the file (0: none); hit_rate is the share of
+// page-ins decompressed instead of read, ratio what the pooled pages
+// compressed by. Page contents are the store's seeded synthetic ones.
+void BM_CompressedSwapFault(benchmark::State& state) {
+    std::string path = "bench_core_swap.bin";
+    BackingStore store(path, 64, 4096, SWAP_PACKED);
+    store.useCompressedTier((size_t)state.range(0) * 1024);
+    SegmentTable st(64, 4096, FIFO);
+    st.physMem->store = &store;
+    st.addSegment(0, 0, 16, READ_WRITE, 16, 64);
+
+    std::vector<LogicalAddress> addrs;
+    Rng gen(1);
+    for (int i = 0; i < 1024; ++i) {
+        int page = (int)gen.uniform(1024);
+        addrs.push_back({0, page / 64, page % 64, 0, READ_ONLY});
+    }
+
+    AllocationCounter allocs(state);
+    size_t i = 0;
+    for (auto _ : state) {
+        const LogicalAddress& a = addrs[i++ & 1023];
+        int latency;
+        benchmark::DoNotOptimize(st.translateAddress(a.segNum, a.pageDir, a.pageNum, a.offset, a.access, latency));
+    }
+    long faults = store.tier_hits + store.swap_ins;
+    state.counters["hit_rate"] = faults ? (double)store.tier_hits / faults : 0.0;
+    state.counters["ratio"] = store.tier_bytes_out ? (double)store.tier_bytes_in / store.tier_bytes_out : 0.0;
+}
+BENCHMARK(BM_CompressedSwapFault)->Arg(0)->Arg(16)->Arg(256);
+
+// Generation cost per address of each synthetic pattern, in batches of 1024
+void BM_Workload(benchmark::State& state, const char* spec) {
+    SegmentTable st(64, 4096, FIFO);
+    addSegments(st, {8, 16, 64});
+    auto workload = makeWorkload(spec, st, 1);
+    std::vector<LogicalAddress> addrs(1024);
+
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        workload->generate(addrs);
+        benchmark::DoNotOptimize(addrs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)addrs.size());
+}
+BENCHMARK_CAPTURE(BM_Workload, uniform, "uniform");
+BENCHMARK_CAPTURE(BM_Workload, zipf, "zipf");
+BENCHMARK_CAPTURE(BM_Workload, seq, "seq");
+BENCHMARK_CAPTURE(BM_Workload, loop, "loop:100");
+BENCHMARK_CAPTURE(BM_Workload, phased, "phased:5000:zipf/loop:100/seq");
+
+int main(int argc, char** argv) {
+    verbose = false;
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,474 +1,550 @@
 #include <iostream>
-#include <vector>
-#include <map>
-#include <queue>
 #include <cstdlib>
-#include <ctime>
-#include <fstream>
 #include <string>
-#include <random>
 #include <chrono>
-#include <iomanip> 
-#include <sstream> 
 #include <climits>
-#include <algorithm>
-
-enum ReplacementAlgorithm { FIFO, LRU };
-
-enum Protection { READ_ONLY, READ_WRITE };
-
-struct Page {
-    int frame_number = -1;
-    bool present = false;
-    Protection protection = READ_WRITE;
-    int last_access_time = 0;
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <initializer_list>
+
+#include "vmsim.hpp"
+#include "drivers.hpp"
+#include "session.hpp"
+#include "snapshot.hpp"
+#include "sweep.hpp"
+#include "replay.hpp"
+#include "live_metrics.hpp"
+
+struct Options {
+    bool scripted = false; // any option besides --seed, --capture and --readahead: run without prompts
+    uint64_t seed = 0;
+    ReplacementAlgorithm algo = FIFO;
+    int num_frames = 64;
+    int page_size = 1000;
+    std::string config_path; // empty: random segments
+    int num_segments = 4;
+    std::string trace_path;
+    int random_count = 0;
+    std::string workload;    // --random address pattern; empty: uniform over segments
+    std::string output_path = "results.vmrl";
+    bool readahead = false;
+    bool verbose = false;
+    bool latency = false;      // per-fault-type latency percentiles
+    std::string load_snapshot; // restore instead of building segments
+    std::string save_snapshot; // checkpoint after the runs
+    std::string swap_path;     // backing store file; empty: evicted pages vanish
+    SwapLayout swap_layout = SWAP_PACKED;
+    std::string swap_io = "sync"; // sync, async (io_uring, else threads) or threads
+    int swap_depth = 32;
+    int compressed_tier_kib = 0; // 0: evicted pages go straight to the file
+    std::string metrics_path;    // Prometheus text stats file; empty: none
+    std::string capture_path;    // binary trace of every translated address; empty: none
+    int metrics_interval = 1000; // ms between rewrites
+    // sweep mode: any --sweep-* option; empty lists fall back to the single value
+    bool sweep = false;
+    std::vector<ReplacementAlgorithm> sweep_policies;
+    std::vector<int> sweep_frames;
+    std::vector<int> sweep_page_sizes;
+    std::string sweep_output = "sweep.csv";
+    int threads = 0; // 0: one per core
+    // replay mode: every trace in the list under every sweep configuration
+    std::string replay_list;
+    std::string replay_output = "replay.csv";
+    int chunk = 65536;
+    // multi-process mode: --random accesses spread over this many address spaces
+    int processes = 1;
+    int quantum = 100;
+    bool untagged_tlb = false;
+    bool fork = false;
 };
 
-struct Segment {
-    int base_address;
-    int limit;
-    Protection protection;
-};
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [--seed N] [--capture PATH] [--readahead]  interactive session\n"
+              << "       " << prog << " [options]                                  scripted run, no prompts\n"
+              << "  --policy fifo|lru     replacement algorithm (default fifo)\n"
+              << "  --frames N            physical frames (default 64)\n"
+              << "  --page-size N         page size (default 1000)\n"
+              << "  --config PATH         segment config file (default: random segments)\n"
+              << "  --segments N          random segments when no config (default 4)\n"
+              << "  --trace PATH          replay a batch trace (text or binary)\n"
+              << "  --random N            generate N random addresses\n"
+              << "  --workload SPEC       pattern for --random: uniform, zipf[:THETA], seq,\n"
+              << "                        stride:N, loop:PAGES or phased:LEN:SPEC/SPEC/...\n"
+              << "  --output PATH         binary results log (default results.vmrl)\n"
+              << "  --seed N              PRNG seed\n"
+              << "  --readahead           enable sequential readahead\n"
+              << "  --load-snapshot PATH  start from a saved simulator state (overrides\n"
+              << "                        --policy/--frames/--page-size/--config)\n"
+              << "  --save-snapshot PATH  save the simulator state after the runs\n"
+              << "  --swap PATH           back memory with a swap file (removed on exit)\n"
+              << "  --swap-layout packed|table  swap slot placement (default packed)\n"
+              << "  --swap-io sync|async|threads  page-in reads: pread, io_uring (falling\n"
+              << "                        back to threads) or a pread thread pool\n"
+              << "  --swap-depth N        asynchronous reads in flight (default 32)\n"
+              << "  --compressed-tier KIB keep evicted pages compressed in a pool of up\n"
+              << "                        to KIB KiB in front of the swap file\n"
+              << "  --capture PATH        save every translated address as a binary trace,\n"
+              << "                        replayable with --trace\n"
+              << "  --metrics PATH        rewrite live Prometheus-format stats to PATH\n"
+              << "  --metrics-interval MS how often (default 1000)\n"
+              << "  --verbose             print per-access diagnostics\n"
+              << "  --latency             latency percentiles per fault type, simulated\n"
+              << "                        and wall-clock (slows translation)\n"
+              << "Sweep mode (replays --trace once per combination, in parallel):\n"
+              << "  --sweep-policies LIST   e.g. fifo,lru (default: --policy)\n"
+              << "  --sweep-frames LIST     e.g. 16,32,64 (default: --frames)\n"
+              << "  --sweep-page-sizes LIST e.g. 1000,4096 (default: --page-size)\n"
+              << "  --sweep-output PATH     results CSV (default sweep.csv)\n"
+              << "  --threads N             worker threads (default: one per core)\n"
+              << "Replay mode (each trace under each sweep configuration, work-stealing):\n"
+              << "  --replay-list PATH      file with one trace path per line\n"
+              << "  --replay-output PATH    results CSV (default replay.csv)\n"
+              << "  --chunk N               accesses per task (default 65536)\n"
+              << "Multi-process mode (--random accesses over address spaces sharing memory):\n"
+              << "  --processes N           address spaces, each with its own segments\n"
+              << "  --quantum N             accesses per time slice (default 100)\n"
+              << "  --untagged-tlb          flush the TLB on every context switch\n"
+              << "  --fork                  ASID 0 reads every page, then forks the others\n"
+              << "                          copy-on-write\n";
+}
 
-class PageTable; 
+bool parseInt(const char* text, int minValue, int& out) {
+    char* end;
+    long v = std::strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || v < minValue || v > INT_MAX) return false;
+    out = (int)v;
+    return true;
+}
 
-std::map<int, std::pair<PageTable*, int>> frame_to_page_map;
+// Comma-separated integers, each at least minValue
+bool parseIntList(const char* text, int minValue, std::vector<int>& out) {
+    std::string list = text;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        int v;
+        if (!parseInt(list.substr(start, comma - start).c_str(), minValue, v)) return false;
+        out.push_back(v);
+        start = comma + 1;
+    }
+    return true;
+}
+
+bool parsePolicy(const std::string& name, ReplacementAlgorithm& algo) {
+    if (name == "fifo") algo = FIFO;
+    else if (name == "lru") algo = LRU;
+    else return false;
+    return true;
+}
 
-// --- PageTable must be a complete type before PageDirectory uses it by value ---
-class PageTable {
-public:
-    std::vector<Page> pages;
-    int page_size;
+bool parseArgs(int argc, char** argv, Options& opt) {
+    opt.seed = std::chrono::system_clock::now().time_since_epoch().count();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
 
-    PageTable(int numPages, int pSize) : page_size(pSize) {
-        pages.resize(numPages);
-        for (auto& p : pages) {
-            p.present = false;
-            p.protection = (rand() % 2) ? READ_WRITE : READ_ONLY;
-            p.frame_number = -1;
-            p.last_access_time = 0;
+        if (arg == "--seed" && hasValue) {
+            if (!parseSeed(argv[++i], opt.seed)) return false;
+            continue;
         }
-    }
-    
-    PageTable() : page_size(1000) {
-        pages.resize(100);
-        for (auto& p : pages) {
-            p.present = false;
-            p.protection = READ_WRITE;
-            p.frame_number = -1;
-            p.last_access_time = 0;
+        if (arg == "--capture" && hasValue) {
+            opt.capture_path = argv[++i];
+            continue;
         }
-    }
-
-    int getFrameNumber(int pageNum, int time, Protection accessType, std::string& fault) {
-        if (pageNum < 0 || pageNum >= (int)pages.size()) {
-            fault = "Page Fault: Invalid page number";
-            std::cout << fault << " " << pageNum << "\n";
-            return -1;
+        if (arg == "--readahead") {
+            opt.readahead = true;
+            continue;
         }
 
-        if (accessType == READ_WRITE && pages[pageNum].protection == READ_ONLY) {
-            fault = "Protection Violation: Cannot write to read-only page";
-            std::cout << fault << "\n";
-            return -1;
+        opt.scripted = true;
+        if (arg == "--verbose") {
+            opt.verbose = true;
+        } else if (arg == "--latency") {
+            opt.latency = true;
+        } else if (arg == "--untagged-tlb") {
+            opt.untagged_tlb = true;
+        } else if (arg == "--fork") {
+            opt.fork = true;
+        } else if (!hasValue) {
+            return false;
+        } else if (arg == "--policy") {
+            if (!parsePolicy(argv[++i], opt.algo)) return false;
+        } else if (arg == "--frames") {
+            if (!parseInt(argv[++i], 1, opt.num_frames)) return false;
+        } else if (arg == "--page-size") {
+            if (!parseInt(argv[++i], 1, opt.page_size)) return false;
+        } else if (arg == "--segments") {
+            if (!parseInt(argv[++i], 1, opt.num_segments)) return false;
+        } else if (arg == "--random") {
+            if (!parseInt(argv[++i], 1, opt.random_count)) return false;
+        } else if (arg == "--config") {
+            opt.config_path = argv[++i];
+        } else if (arg == "--trace") {
+            opt.trace_path = argv[++i];
+        } else if (arg == "--swap") {
+            opt.swap_path = argv[++i];
+        } else if (arg == "--swap-layout") {
+            std::string name = argv[++i];
+            if (name == "packed") opt.swap_layout = SWAP_PACKED;
+            else if (name == "table") opt.swap_layout = SWAP_BY_TABLE;
+            else return false;
+        } else if (arg == "--swap-io") {
+            opt.swap_io = argv[++i];
+            if (opt.swap_io != "sync" && opt.swap_io != "async" && opt.swap_io != "threads") return false;
+        } else if (arg == "--swap-depth") {
+            if (!parseInt(argv[++i], 1, opt.swap_depth)) return false;
+        } else if (arg == "--workload") {
+            opt.workload = argv[++i];
+        } else if (arg == "--metrics") {
+            opt.metrics_path = argv[++i];
+        } else if (arg == "--metrics-interval") {
+            if (!parseInt(argv[++i], 1, opt.metrics_interval)) return false;
+        } else if (arg == "--compressed-tier") {
+            if (!parseInt(argv[++i], 0, opt.compressed_tier_kib)) return false;
+        } else if (arg == "--output") {
+            opt.output_path = argv[++i];
+        } else if (arg == "--load-snapshot") {
+            opt.load_snapshot = argv[++i];
+        } else if (arg == "--save-snapshot") {
+            opt.save_snapshot = argv[++i];
+        } else if (arg == "--sweep-policies") {
+            opt.sweep = true;
+            std::string list = argv[++i];
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t comma = list.find(',', start);
+                if (comma == std::string::npos) comma = list.size();
+                ReplacementAlgorithm algo;
+                if (!parsePolicy(list.substr(start, comma - start), algo)) return false;
+                opt.sweep_policies.push_back(algo);
+                start = comma + 1;
+            }
+        } else if (arg == "--sweep-frames") {
+            opt.sweep = true;
+            if (!parseIntList(argv[++i], 1, opt.sweep_frames)) return false;
+        } else if (arg == "--sweep-page-sizes") {
+            opt.sweep = true;
+            if (!parseIntList(argv[++i], 1, opt.sweep_page_sizes)) return false;
+        } else if (arg == "--sweep-output") {
+            opt.sweep = true;
+            opt.sweep_output = argv[++i];
+        } else if (arg == "--replay-list") {
+            opt.replay_list = argv[++i];
+        } else if (arg == "--replay-output") {
+            opt.replay_output = argv[++i];
+        } else if (arg == "--chunk") {
+            if (!parseInt(argv[++i], 1, opt.chunk)) return false;
+        } else if (arg == "--processes") {
+            if (!parseInt(argv[++i], 1, opt.processes)) return false;
+        } else if (arg == "--quantum") {
+            if (!parseInt(argv[++i], 1, opt.quantum)) return false;
+        } else if (arg == "--threads") {
+            if (!parseInt(argv[++i], 1, opt.threads)) return false;
+        } else {
+            return false;
         }
+    }
+    return true;
+}
 
-        if (!pages[pageNum].present) {
-            fault = "Page Fault: Page not in memory";
-            std::cout << fault << " " << pageNum << "\n";
-            return -2;
-        }
+// The --sweep-* lists, each defaulting to the single-run setting
+std::vector<SweepConfig> optionGrid(const Options& opt) {
+    return sweepGrid(
+        opt.sweep_policies.empty() ? std::vector<ReplacementAlgorithm>{opt.algo} : opt.sweep_policies,
+        opt.sweep_frames.empty() ? std::vector<int>{opt.num_frames} : opt.sweep_frames,
+        opt.sweep_page_sizes.empty() ? std::vector<int>{opt.page_size} : opt.sweep_page_sizes);
+}
 
-        pages[pageNum].last_access_time = time;
-        return pages[pageNum].frame_number;
+// Replays every listed trace under every grid point on the work-stealing pool
+int runReplayMode(const Options& opt, SegmentTable& st) {
+    std::ifstream list(opt.replay_list);
+    if (!list.is_open() || !opt.load_snapshot.empty()) {
+        std::cout << "Replay mode needs a readable --replay-list and a fresh layout (no --load-snapshot).\n";
+        return 1;
+    }
+    std::vector<ReplayJob> jobs;
+    std::vector<SweepConfig> grid = optionGrid(opt);
+    std::string path;
+    while (std::getline(list, path)) {
+        if (path.empty() || path[0] == '#') continue;
+        for (const SweepConfig& config : grid) jobs.push_back({path, config});
     }
 
-    void setFrame(int pageNum, int frame, Protection prot, int time) {
-        if (pageNum >= 0 && pageNum < (int)pages.size()) {
-            pages[pageNum].frame_number = frame;
-            pages[pageNum].present = true;
-            pages[pageNum].protection = prot;
-            pages[pageNum].last_access_time = time;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<WorkerStats> workers;
+    std::vector<ReplayJobResult> results = replayTraces(st, jobs, opt.threads, opt.chunk, workers);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-            frame_to_page_map[frame] = {this, pageNum};
-        }
+    std::ofstream out(opt.replay_output);
+    if (!out.is_open()) {
+        std::cout << "Error: Could not write " << opt.replay_output << "\n";
+        return 1;
     }
-
-    void invalidatePage(int pageNum) {
-        if (pageNum >= 0 && pageNum < (int)pages.size()) {
-            pages[pageNum].frame_number = -1;
-            pages[pageNum].present = false;
+    writeReplayCsv(out, results);
+    for (const ReplayJobResult& r : results) {
+        if (!r.loaded) {
+            std::cout << "Warning: Could not load batch file " << r.trace_path << ": " << r.load_error << "\n";
         }
     }
-};
-
-class PageDirectory {
-public:
-    std::map<int, PageTable> page_tables; 
-    int page_table_size; 
-
-    PageDirectory(int defaultPageTableSize = 100) : page_table_size(defaultPageTableSize) {}
+    printWorkerStats(std::cout, workers);
+    std::cout << "Replayed " << jobs.size() << " jobs in " << seconds << "s; results in "
+              << opt.replay_output << "\n";
+    return 0;
+}
 
-    PageTable* getPageTable(int pageDirIndex) {
-        if (page_tables.find(pageDirIndex) == page_tables.end()) {
-            return nullptr;
-        }
-        return &page_tables[pageDirIndex];
+// Replays the trace once per grid point against copies of st's layout
+int runSweepMode(const Options& opt, SegmentTable& st) {
+    if (opt.trace_path.empty() || !opt.load_snapshot.empty()) {
+        std::cout << "Sweep mode needs --trace and a fresh layout (no --load-snapshot).\n";
+        return 1;
     }
-    
-    void addPageTable(int pageDirIndex, int numPages, int pageSize) {
-         page_tables[pageDirIndex] = PageTable(numPages, pageSize);
+    Trace trace(st);
+    if (!trace.load(opt.trace_path)) {
+        std::cout << "Error: Could not load batch file " << opt.trace_path << ": " << trace.load_error << "\n";
+        return 1;
     }
-};
 
+    std::vector<SweepConfig> grid = optionGrid(opt);
 
-class PhysicalMemory {
-public:
-    int num_frames;
-    std::vector<bool> free_frames;
-    std::queue<int> fifo_queue; 
-    int time = 0;
-    ReplacementAlgorithm algo; 
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results = runSweep(st, trace, grid, opt.threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-    PhysicalMemory(int frames, ReplacementAlgorithm algorithm) 
-        : num_frames(frames), algo(algorithm) {
-        free_frames.resize(frames, true);
+    std::ofstream out(opt.sweep_output);
+    if (!out.is_open()) {
+        std::cout << "Error: Could not write " << opt.sweep_output << "\n";
+        return 1;
     }
+    writeSweepCsv(out, results);
+    std::cout << "Swept " << grid.size() << " configurations over " << trace.size() << " accesses in "
+              << seconds << "s; results in " << opt.sweep_output << "\n";
+    return 0;
+}
 
-    int allocateFrame() {
-        // try free frame first
-        for (int i = 0; i < num_frames; ++i) {
-            if (free_frames[i]) {
-                free_frames[i] = false;
-                if (algo == FIFO) {
-                    fifo_queue.push(i);
-                }
-                std::cout << "-> Allocated free frame " << i << "\n";
-                return i;
-            }
-        }
-
-        std::cout << "-> No free frames. Running page replacement...\n";
-        int victimFrame = -1;
-
-        if (algo == FIFO) {
-            if (fifo_queue.empty()) return -1; 
-            victimFrame = fifo_queue.front();
-            fifo_queue.pop();
-            fifo_queue.push(victimFrame);
-            std::cout << "-> FIFO victim: frame " << victimFrame << "\n";
-
-        } else { 
-            int minTime = INT_MAX;
-            for(auto const& [frame, page_info] : frame_to_page_map) {
-                PageTable* pt = page_info.first;
-                int pageNum = page_info.second;
-                if (pt->pages[pageNum].last_access_time < minTime) {
-                    minTime = pt->pages[pageNum].last_access_time;
-                    victimFrame = frame;
-                }
-            }
-            std::cout << "-> LRU victim: frame " << victimFrame << "\n";
-        }
+// A swap file and its read engine; the engine outlives the store, and
+// both outlive the tables using them
+struct SwapDevice {
+    std::unique_ptr<FaultIo> io;
+    std::unique_ptr<BackingStore> store;
 
-        if (victimFrame != -1) {
-            if (frame_to_page_map.count(victimFrame)) {
-                auto& victim_page_info = frame_to_page_map[victimFrame];
-                PageTable* victim_pt = victim_page_info.first;
-                int victim_pageNum = victim_page_info.second;
-                
-                std::cout << "-> Evicting page " << victim_pageNum 
-                          << " from frame " << victimFrame << ".\n";
-                
-                victim_pt->invalidatePage(victim_pageNum);
-                frame_to_page_map.erase(victimFrame); 
-            }
-            // mark victim frame as allocated for immediate reuse
-            if (victimFrame >= 0 && victimFrame < num_frames) {
-                free_frames[victimFrame] = false;
-            }
-        }
-        
-        return victimFrame;
+    void finish() {
+        if (!store) return;
+        store->drain();
+        store->printStats(std::cout);
     }
+};
 
-    void freeFrame(int frame) {
-        if (frame >= 0 && frame < num_frames) {
-            free_frames[frame] = true;
-            if(frame_to_page_map.count(frame)) {
-                frame_to_page_map.erase(frame);
-            }
-        }
+// Attaches a swap file to mem when --swap is given; false if it cannot be opened
+bool attachSwap(const Options& opt, PhysicalMemory& mem, int pageSize, SwapDevice& swap) {
+    if (opt.swap_path.empty()) return true;
+    swap.store = std::make_unique<BackingStore>(opt.swap_path, mem.num_frames, pageSize, opt.swap_layout);
+    if (!swap.store->is_open()) {
+        std::cout << "Error: Could not open swap file " << opt.swap_path << "\n";
+        return false;
+    }
+    if (opt.swap_io != "sync") {
+        swap.io = makeFaultIo(opt.swap_depth, opt.swap_io == "async");
+        swap.store->useAsyncReads(swap.io.get(), opt.swap_depth);
     }
+    if (opt.compressed_tier_kib > 0) swap.store->useCompressedTier((size_t)opt.compressed_tier_kib * 1024);
+    swap.store->seedContents(opt.seed);
+    mem.store = swap.store.get();
+    return true;
+}
 
-    double utilization() const {
-        int used = std::count(free_frames.begin(), free_frames.end(), false);
-        return (double)used / num_frames * 100;
+// Live counters for --metrics and the thread exporting them; it writes a
+// last sample when it goes
+struct MetricsSink {
+    LiveMetrics metrics;
+    std::unique_ptr<MetricsExporter> exporter;
+
+    // The counters to attach, or nullptr without --metrics
+    LiveMetrics* start(const Options& opt) {
+        if (opt.metrics_path.empty()) return nullptr;
+        exporter = std::make_unique<MetricsExporter>(metrics, opt.metrics_path, opt.metrics_interval);
+        return &metrics;
     }
 };
 
-
-class SegmentTable {
-public:
-    std::vector<Segment> segments;
-    std::map<int, PageDirectory> segment_directories;
-    PhysicalMemory* physMem;
-    int page_size; 
-
-    SegmentTable(int numFrames, int pSize, ReplacementAlgorithm algo) 
-        : page_size(pSize) {
-        physMem = new PhysicalMemory(numFrames, algo);
-    }
-    
-    ~SegmentTable() {
-        delete physMem; 
+// Several address spaces with their own segments competing for one memory
+int runProcessMode(const Options& opt) {
+    if (opt.random_count == 0) {
+        std::cout << "Multi-process mode needs --random.\n";
+        return 1;
     }
-
-    void addSegment(int id, int base, int limit, Protection prot, int dirSize, int tableSize) {
-        segments.push_back({base, limit, prot});
-        segment_directories[id] = PageDirectory(tableSize);
-        for(int i=0; i < dirSize; ++i) {
-             segment_directories[id].addPageTable(i, tableSize, page_size);
+    MetricsSink sink;
+    SwapDevice swap; // outlives the address spaces
+    AddressSpaceManager manager(opt.num_frames, opt.algo);
+    manager.flush_on_switch = opt.untagged_tlb;
+    if (!attachSwap(opt, manager.memory, opt.page_size, swap)) return 1;
+    for (int asid = 0; asid < (opt.fork ? 1 : opt.processes); ++asid) {
+        SegmentTable* st = manager.createAddressSpace(asid, opt.page_size, opt.seed + asid);
+        st->readahead.enabled = opt.readahead;
+        if (!opt.config_path.empty()) {
+            loadConfigFromFile(*st, opt.config_path);
+        } else {
+            initRandomSegments(*st, opt.num_segments);
         }
     }
-
-    int translateAddress(int segNum, int pageDir, int pageNum, int offset, Protection accessType, int& latency, std::string& fault) {
-        physMem->time++;
-        latency = 1 + rand() % 5; 
-        fault = "OK";
-
-        if (segNum < 0 || segNum >= (int)segments.size()) {
-            fault = "Segmentation Fault: Invalid segment";
-            std::cout << fault << " " << segNum << "\n";
-            return -1;
-        }
-        Segment& segment = segments[segNum];
-
-        if (accessType == READ_WRITE && segment.protection == READ_ONLY) {
-            fault = "Protection Violation: Cannot write to read-only segment";
-            std::cout << fault << "\n";
-            return -1;
-        }
-
-        if (segment_directories.find(segNum) == segment_directories.end()) {
-             fault = "Segmentation Fault: No page directory for segment";
-             std::cout << fault << " " << segNum << "\n";
-             return -1;
-        }
-        PageDirectory* dir = &segment_directories[segNum];
-
-        PageTable* pt = dir->getPageTable(pageDir);
-        if (pt == nullptr) {
-            fault = "Page Fault: Invalid page directory index";
-            std::cout << fault << " " << pageDir << "\n";
-            return -1;
+    if (opt.fork) {
+        // fault the parent's pages in so the children have something to share
+        SegmentTable* parent = manager.find(0);
+        for (auto& [seg, dir] : parent->segment_directories) {
+            for (auto& [idx, pt] : dir.page_tables) {
+                for (int p = 0; p < (int)pt.pages.size(); ++p) {
+                    int latency;
+                    parent->translateAddress(seg, idx, p, 0, READ_ONLY, latency);
+                }
+            }
         }
-        
-        if (pageNum < 0 || pageNum >= (int)pt->pages.size()) {
-             fault = "Page Fault: Page number exceeds limit";
-             std::cout << fault << " " << pageNum << "\n";
-             return -1;
-        }
-        
-        if (offset < 0 || offset >= pt->page_size) {
-            fault = "Offset Fault: Offset exceeds page size";
-            std::cout << fault << " " << offset << "\n";
-            return -1;
+        for (int asid = 1; asid < opt.processes; ++asid) {
+            manager.fork(0, asid, opt.seed + asid);
         }
+        std::cout << "Forked " << opt.processes - 1 << " children, "
+                  << manager.memory.sharedMappings() << " page mappings shared\n";
+    }
+    LiveMetrics* live = sink.start(opt);
+    for (auto const& [asid, st] : manager.addressSpaces()) st->live_metrics = live;
+    simulateAddressSpaces(manager, opt.random_count, opt.quantum);
+    swap.finish();
+    return 0;
+}
 
-        int frame = pt->getFrameNumber(pageNum, physMem->time, accessType, fault);
+struct GivenOption {
+    bool given;
+    const char* name;
+};
 
-        if (frame == -1) { 
-            return -1;
+// False, after saying so, if any of options was given to a mode that
+// would ignore it
+bool rejectInMode(const char* mode, std::initializer_list<GivenOption> options) {
+    for (const GivenOption& o : options) {
+        if (o.given) {
+            std::cout << o.name << " is not supported with " << mode << ".\n";
+            return false;
         }
-        
-        if (frame == -2) { 
-            std::cout << "-> Handling Page Fault...\n";
-            latency += 100;
-            
-            frame = physMem->allocateFrame(); 
-            if (frame == -1) {
-                fault = "Error: Page replacement failed";
-                std::cout << fault << "\n";
-                return -1;
-            }
-            
-            pt->setFrame(pageNum, frame, segment.protection, physMem->time);
-        }
-
-        return (frame * pt->page_size) + offset;
     }
+    return true;
+}
 
-    void printMemoryMap() {
-        std::cout << "\n--- Memory Map ---\n";
-        std::cout << "Physical Memory Utilization: " << physMem->utilization() << "%\n";
-        std::cout << "Current Time: " << physMem->time << "\n";
-        
-        std::cout << "Frames in Use: \n";
-        for (auto const& [frame, page_info] : frame_to_page_map) {
-             PageTable* pt = page_info.first;
-             int pageNum = page_info.second;
-             std::cout << "  [Frame " << std::setw(2) << frame << "]:"
-                       << " Page " << std::setw(2) << pageNum
-                       << " (Last Access: " << pt->pages[pageNum].last_access_time << ")\n";
-        }
-        std::cout << "-------------------\n";
+// Options that only make sense together; false, after saying why, for a
+// combination that would silently ignore one of them
+bool checkOptions(const Options& opt) {
+    if (!opt.workload.empty() && opt.random_count == 0) {
+        std::cout << "--workload shapes the --random addresses; give --random too.\n";
+        return false;
     }
-};
-
-void loadConfigFromFile(SegmentTable& st, const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cout << "Error: Could not open config file " << filename << ". Using random init.\n";
-        return;
+    // a trace has no address-space column, so there is nothing to capture
+    if (opt.processes > 1) {
+        return rejectInMode("--processes", {{!opt.workload.empty(), "--workload"},
+                                            {!opt.trace_path.empty(), "--trace"},
+                                            {!opt.load_snapshot.empty(), "--load-snapshot"},
+                                            {!opt.save_snapshot.empty(), "--save-snapshot"},
+                                            {opt.sweep, "--sweep-*"},
+                                            {!opt.replay_list.empty(), "--replay-list"},
+                                            {!opt.capture_path.empty(), "--capture"},
+                                            {opt.latency, "--latency"}});
     }
-    
-    std::string line;
-    int lineNum = 0;
-    while (std::getline(file, line)) {
-        lineNum++;
-        if (line.empty() || line[0] == '#') {
-            continue; 
-        }
-        
-        std::stringstream ss(line);
-        int segId, dirSize, tableSize, protInt;
-        
-        if (ss >> segId >> dirSize >> tableSize >> protInt) {
-            Protection prot = (protInt == 1) ? READ_WRITE : READ_ONLY;
-            st.addSegment(segId, 0, dirSize, prot, dirSize, tableSize);
-            std::cout << "Loaded segment " << segId << " from file.\n";
-        } else {
-            std::cout << "Warning: Skipping malformed line " << lineNum << " in config file.\n";
-        }
+    // sweep and replay runs build their own tables, one per configuration
+    if (!opt.replay_list.empty() || opt.sweep) {
+        const char* mode = opt.replay_list.empty() ? "the --sweep-* options" : "--replay-list";
+        return rejectInMode(mode, {{!opt.swap_path.empty(), "--swap"},
+                                   {!opt.capture_path.empty(), "--capture"},
+                                   {opt.random_count > 0, "--random"},
+                                   {opt.latency, "--latency"},
+                                   {!opt.save_snapshot.empty(), "--save-snapshot"},
+                                   {!opt.replay_list.empty() && !opt.trace_path.empty(), "--trace"}});
     }
-    file.close();
+    return true;
 }
 
+// Scripted run: no prompts and no memory-map dumps
+int runScripted(const Options& opt) {
+    verbose = opt.verbose;
+    latency_report |= opt.latency;
+    if (!checkOptions(opt)) return 1;
+    if (opt.trace_path.empty() && opt.random_count == 0 && opt.save_snapshot.empty() && opt.replay_list.empty()) {
+        std::cout << "Nothing to run: give --trace, --random, --replay-list and/or --save-snapshot.\n";
+        return 1;
+    }
+    if (opt.processes > 1) {
+        return runProcessMode(opt);
+    }
 
-void generateRandomAddresses(SegmentTable& st, int num, double validRatio, const std::string& logFile) {
-    std::ofstream log(logFile);
-    log << "Time,LogicalAddress,Access,Status,PhysicalAddress,Latency\n";
-    
-    std::mt19937 gen(std::chrono::system_clock::now().time_since_epoch().count());
-    int faults = 0;
-    long total_latency = 0;
-    int successful_translations = 0;
-
-    for (int i = 0; i < num; ++i) {
-        int segNum, pageDir, pageNum, offset, access;
-        int latency;
-        std::string fault;
-        
-        segNum = gen() % st.segments.size();
-        PageDirectory& dir = st.segment_directories[segNum];
-        pageDir = gen() % dir.page_tables.size(); 
-        PageTable* pt = dir.getPageTable(pageDir);
-        if(!pt) continue; 
-        
-        pageNum = gen() % pt->pages.size();
-        offset = gen() % pt->page_size;
-        access = (gen() % 2) ? READ_WRITE : READ_ONLY;
+    MetricsSink sink;
+    SwapDevice swap; // outlives the table
+    SegmentTable segmentTable(opt.num_frames, opt.page_size, opt.algo, opt.seed);
+    segmentTable.readahead.enabled = opt.readahead;
 
-        std::string accessStr = (access == READ_ONLY) ? "Read" : "Write";
-        std::string logicAddr = "(" + std::to_string(segNum) + "," + std::to_string(pageDir) 
-                              + "," + std::to_string(pageNum) + "," + std::to_string(offset) + ")";
-        
-        int addr = st.translateAddress(segNum, pageDir, pageNum, offset, (Protection)access, latency, fault);
-        
-        if (addr == -1) {
-            faults++;
-            log << st.physMem->time << "," << logicAddr << "," << accessStr 
-                << ",FAULT," << fault << "," << latency << "\n";
-        } else {
-            successful_translations++;
-            total_latency += latency;
-            log << st.physMem->time << "," << logicAddr << "," << accessStr 
-                << ",OK," << addr << "," << latency << "\n";
+    if (!opt.load_snapshot.empty()) {
+        if (!restoreSnapshot(segmentTable, opt.load_snapshot)) {
+            std::cout << "Error: Could not load snapshot " << opt.load_snapshot << "\n";
+            return 1;
         }
+        segmentTable.readahead.enabled |= opt.readahead;
+        std::cout << "Restored snapshot " << opt.load_snapshot << " at time " << segmentTable.physMem->time << "\n";
+    } else if (!opt.config_path.empty()) {
+        loadConfigFromFile(segmentTable, opt.config_path);
+    } else {
+        initRandomSegments(segmentTable, opt.num_segments);
     }
-    
-    log << "\n--- Stress Test Metrics ---\n";
-    std::cout << "\n--- Stress Test Metrics ---\n";
-    
-    double faultRate = (double)faults / num * 100;
-    log << "Page Fault/Error Rate: " << faultRate << "%\n";
-    std::cout << "Page Fault/Error Rate: " << faultRate << "%\n";
-
-    double avgLatency = (successful_translations > 0) ? (double)total_latency / successful_translations : 0;
-    log << "Average Translation Latency: " << avgLatency << "\n";
-    std::cout << "Average Translation Latency: " << avgLatency << "\n";
-    
-    log << "Final Memory Utilization: " << st.physMem->utilization() << "%\n";
-    std::cout << "Final Memory Utilization: " << st.physMem->utilization() << "%\n";
-}
 
-void processBatchFile(SegmentTable& st, const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cout << "Error: Could not open batch file " << filename << "\n";
-        return;
+    if (segmentTable.segments.empty()) {
+        std::cout << "No segments loaded or initialized. Exiting.\n";
+        return 1;
+    }
+    segmentTable.live_metrics = sink.start(opt); // sweep and replay runs inherit it
+    if (!opt.replay_list.empty()) {
+        return runReplayMode(opt, segmentTable);
+    }
+    if (opt.sweep) {
+        return runSweepMode(opt, segmentTable);
     }
-    
-    std::cout << "\n--- Processing Batch File: " << filename << " ---\n";
-    std::string line;
-    int lineNum = 0;
-    int faults = 0;
-    long total_latency = 0;
-    int total_translations = 0;
-
-    while (std::getline(file, line)) {
-        lineNum++;
-        if (line.empty() || line[0] == '#') {
-            continue; 
-        }
-        
-        std::stringstream ss(line);
-        int segNum, pageDir, pageNum, offset, access;
-        
-        if (ss >> segNum >> pageDir >> pageNum >> offset >> access) {
-            total_translations++;
-            int latency;
-            std::string fault;
-            Protection accessType = (access == 1) ? READ_WRITE : READ_ONLY;
-            
-            std::string logicAddr = "(" + std::to_string(segNum) + "," + std::to_string(pageDir) 
-                                  + "," + std::to_string(pageNum) + "," + std::to_string(offset) + ")";
-            
-            int physicalAddress = st.translateAddress(segNum, pageDir, pageNum, offset, accessType, latency, fault);
-            total_latency += latency;
-
-            if (physicalAddress != -1) {
-                std::cout << "Time " << st.physMem->time << ": "
-                          << "Logical " << logicAddr
-                          << " -> Physical " << physicalAddress << " (Latency: " << latency << ")\n";
-            } else {
-                faults++;
-                std::cout << "Time " << st.physMem->time << ": "
-                          << "Logical " << logicAddr
-                          << " -> FAULT (" << fault << ")" << " (Latency: " << latency << ")\n";
-            }
 
-        } else {
-            std::cout << "Warning: Skipping malformed line " << lineNum << " in batch file.\n";
+    if (!attachSwap(opt, *segmentTable.physMem, segmentTable.page_size, swap)) return 1;
+    std::unique_ptr<Trace> capture;
+    startCapture(opt.capture_path, segmentTable, capture);
+    if (!opt.trace_path.empty()) {
+        processBatchFile(segmentTable, opt.trace_path);
+    }
+    if (opt.random_count > 0 && !opt.workload.empty()) {
+        std::unique_ptr<Workload> workload = makeWorkload(opt.workload, segmentTable, segmentTable.rng());
+        if (!workload) {
+            std::cout << "Error: Bad workload " << opt.workload << "\n";
+            return 1;
         }
+        if (!generateWorkload(segmentTable, *workload, opt.random_count, opt.output_path)) return 1;
+        std::cout << "Stress test results logged to " << opt.output_path << "\n";
+    } else if (opt.random_count > 0) {
+        if (!generateRandomAddresses(segmentTable, opt.random_count, 0.7, opt.output_path)) return 1;
+        std::cout << "Stress test results logged to " << opt.output_path << "\n";
     }
-    file.close();
-
-    std::cout << "\n--- Batch Processing Summary ---\n";
-    std::cout << "Total Translations: " << total_translations << "\n";
-    std::cout << "Successful: " << (total_translations - faults) << "\n";
-    std::cout << "Faults/Errors: " << faults << "\n";
-    if (total_translations > 0) {
-        std::cout << "Success Rate: " << (double)(total_translations - faults) / total_translations * 100 << "%\n";
-        std::cout << "Average Latency: " << (double)total_latency / total_translations << "\n";
+    swap.finish();
+    if (!saveCapture(opt.capture_path, capture)) return 1;
+    if (!opt.save_snapshot.empty()) {
+        if (!saveSnapshot(segmentTable, opt.save_snapshot)) {
+            std::cout << "Error: Could not write snapshot " << opt.save_snapshot << "\n";
+            return 1;
+        }
+        std::cout << "Snapshot saved to " << opt.save_snapshot << "\n";
     }
-    std::cout << "--------------------------------\n";
+    return 0;
 }
 
 
-int main() {
-    srand(time(0));
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    std::cout << "Seed: " << opt.seed << "\n";
+    if (opt.scripted) {
+        return runScripted(opt);
+    }
+    uint64_t seed = opt.seed;
 
     int algoChoice;
     std::cout << "Select Replacement Algorithm (0=FIFO, 1=LRU): ";
@@ -481,7 +557,9 @@ int main() {
     std::cout << "Enter page size: ";
     std::cin >> pageSize;
 
-    SegmentTable segmentTable(numFrames, pageSize, algo);
+    SegmentTable segmentTable(numFrames, pageSize, algo, seed);
+
+    segmentTable.readahead.enabled = opt.readahead;
 
     char loadFile;
     std::cout << "Load configuration from config.txt? (y/n): ";
@@ -493,17 +571,7 @@ int main() {
         int numSegments;
         std::cout << "Enter number of segments to randomly initialize: ";
         std::cin >> numSegments;
-        
-        int dirSize = 4; 
-        int tableSize = 16;
-        std::cout << "Initializing segments with " << dirSize << " directory entries and " 
-                  << tableSize << " page table entries.\n";
-
-        for (int i = 0; i < numSegments; ++i) {
-            int limit = dirSize;
-            Protection prot = (rand() % 2) ? READ_ONLY : READ_WRITE;
-            segmentTable.addSegment(i, 0, limit, prot, dirSize, tableSize);
-        }
+        initRandomSegments(segmentTable, numSegments);
     }
 
     if (segmentTable.segments.empty()) {
@@ -512,6 +580,8 @@ int main() {
     }
 
     segmentTable.printMemoryMap();
+    std::unique_ptr<Trace> capture;
+    startCapture(opt.capture_path, segmentTable, capture);
     
     char batchMode;
     std::cout << "\nProcess a batch file? (y/n): ";
@@ -538,6 +608,7 @@ int main() {
         int latency;
         std::string fault;
         Protection accessType = (access == 1) ? READ_WRITE : READ_ONLY;
+        if (capture) capture->push(segNum, pageDir, pageNum, offset, accessType);
         
         total_translations++;
         int physicalAddress = segmentTable.translateAddress(segNum, pageDir, pageNum, offset, accessType, latency, fault);
@@ -556,7 +627,7 @@ int main() {
                       << " -> FAULT (" << fault << ")" << " (Latency: " << latency << ")\n";
         }
         
-        segmentTable.printMemoryMap();
+        segmentTable.printMemoryMapChanges();
     }
 
     if (total_translations > 0) {
@@ -568,9 +639,9 @@ int main() {
     char genRand;
     std::cin >> genRand;
     if (genRand == 'y' || genRand == 'Y') {
-        generateRandomAddresses(segmentTable, 200, 0.7, "results.txt");
-        std::cout << "Stress test results logged to results.txt\n";
+        if (!generateRandomAddresses(segmentTable, 200, 0.7, "results.vmrl")) return 1;
+        std::cout << "Stress test results logged to results.vmrl\n";
     }
 
-    return 0;
+    return saveCapture(opt.capture_path, capture) ? 0 : 1;
 }
\ No newline at end of file
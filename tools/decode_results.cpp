@@ -0,0 +1,54 @@
+// Prints a binary results log (see vmsim/results_log.hpp) as the CSV the
+// stress test used to write: one row per access, then the metrics summary.
+//
+//   cmake --build build --target decode_results
+//   ./decode_results results.vmrl [out.csv]   (default: stdout)
+
+#include <iostream>
+#include <fstream>
+#include <string>
+
+#include "results_log.hpp"
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " LOG [CSV]\n";
+        return 2;
+    }
+
+    ResultsLogReader reader;
+    if (!reader.open(argv[1])) {
+        std::cerr << "Error: " << argv[1] << " is not a results log\n";
+        return 1;
+    }
+
+    std::ofstream file;
+    if (argc == 3) {
+        file.open(argv[2]);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open " << argv[2] << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = (argc == 3) ? file : std::cout;
+
+    out << "Time,LogicalAddress,Access,Status,PhysicalAddress,Latency\n";
+    ResultRecord r;
+    std::string line;
+    while (reader.next(r)) {
+        line.clear();
+        line += std::to_string(r.time);
+        line += ",(" + std::to_string(r.addr.segNum) + "," + std::to_string(r.addr.pageDir) + ","
+              + std::to_string(r.addr.pageNum) + "," + std::to_string(r.addr.offset) + "),";
+        line += (r.addr.access == READ_ONLY) ? "Read" : "Write";
+        if (r.physical_address == -1) {
+            line += ",FAULT," + r.fault;
+        } else {
+            line += ",OK," + std::to_string(r.physical_address);
+        }
+        line += "," + std::to_string(r.latency) + "\n";
+        out << line;
+    }
+    out << reader.summary();
+    return 0;
+}
@@ -0,0 +1,205 @@
+#ifndef ADDRESS_SPACE_HPP
+#define ADDRESS_SPACE_HPP
+
+// Several processes, each an address space (a SegmentTable tagged with an
+// ASID), drawing frames from one PhysicalMemory under one replacement
+// policy, so tenants evict each other's pages. Translations go through an
+// ASID-tagged TLB: a context switch only changes the current ASID, and
+// entries of other address spaces stay cached for when they run again.
+//
+// Evictions need no TLB shootdown: each entry remembers the Page it came
+// from and the frame it was in, and a hit is only used while that page is
+// still present in that frame.
+//
+// fork() gives a new address space the parent's layout and maps its
+// resident pages copy-on-write, so forked tenants only take frames for
+// the pages they write.
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "vmsim.hpp"
+
+struct TlbEntry {
+    int asid = -1; // -1: empty
+    int seg = 0;
+    int dir = 0;
+    int page = 0;
+    Page* pte = nullptr;
+    int frame = -1;
+    int page_size = 0;
+    bool seg_read_only = false;
+};
+
+// Direct-mapped; size is rounded up to a power of two
+class Tlb {
+public:
+    long hits = 0;
+    long misses = 0;
+    long stale = 0; // tag matched but the page had been evicted or moved
+    long flushes = 0;
+
+    explicit Tlb(int size = 256) {
+        int n = 1;
+        while (n < size) n <<= 1;
+        entries.resize(n);
+    }
+
+    TlbEntry& slot(int asid, int seg, int dir, int page) {
+        uint32_t h = (uint32_t)page * 0x9E3779B1u ^ (uint32_t)dir * 0x85EBCA77u
+                     ^ (uint32_t)seg * 0xC2B2AE3Du ^ (uint32_t)asid * 0x27D4EB2Fu;
+        return entries[(h ^ (h >> 15)) & (entries.size() - 1)];
+    }
+
+    void flush() {
+        for (TlbEntry& e : entries) e.asid = -1;
+        flushes++;
+    }
+
+    void flushAsid(int asid) {
+        for (TlbEntry& e : entries) {
+            if (e.asid == asid) e.asid = -1;
+        }
+    }
+
+    size_t size() const { return entries.size(); }
+
+private:
+    std::vector<TlbEntry> entries;
+};
+
+class AddressSpaceManager {
+public:
+    PhysicalMemory memory;
+    Tlb tlb;
+    bool flush_on_switch = false; // untagged behaviour, for comparison
+    long context_switches = 0;
+
+    AddressSpaceManager(int numFrames, ReplacementAlgorithm algo, int tlbEntries = 256)
+        : memory(numFrames, algo), tlb(tlbEntries) {}
+
+    AddressSpaceManager(const AddressSpaceManager&) = delete;
+    AddressSpaceManager& operator=(const AddressSpaceManager&) = delete;
+
+    // New empty address space; nullptr if the ASID is taken
+    SegmentTable* createAddressSpace(int asid, int pageSize, uint64_t seed = 1) {
+        if (asid < 0 || spaces.count(asid)) return nullptr;
+        auto& st = spaces[asid];
+        st = std::make_unique<SegmentTable>(&memory, pageSize, asid, seed);
+        return st.get();
+    }
+
+    // Frees the address space's frames and drops its TLB entries, which
+    // point into page tables that are about to go away
+    bool destroyAddressSpace(int asid) {
+        auto it = spaces.find(asid);
+        if (it == spaces.end()) return false;
+        if (active == it->second.get()) active = nullptr;
+        tlb.flushAsid(asid);
+        spaces.erase(it);
+        return true;
+    }
+
+    // New address space with parent's segments and page tables whose
+    // resident pages it shares copy-on-write; nullptr if parent is missing
+    // or child is taken
+    SegmentTable* fork(int parent, int child, uint64_t seed = 1) {
+        SegmentTable* from = find(parent);
+        if (from == nullptr) return nullptr;
+        SegmentTable* st = createAddressSpace(child, from->page_size, seed);
+        if (st == nullptr) return nullptr;
+
+        st->segments = from->segments;
+        for (auto const& [id, dir] : from->segment_directories) {
+            PageDirectory& copy = st->segment_directories[id];
+            copy.page_table_size = dir.page_table_size;
+            for (auto const& [idx, pt] : dir.page_tables) {
+                PageTable& table = copy.page_tables.try_emplace(idx, pt.page_size, pt.pages).first->second;
+                for (int p = 0; p < (int)table.pages.size(); ++p) table.invalidatePage(p);
+            }
+        }
+        for (auto const& [id, dir] : from->segment_directories) {
+            st->sharePages(id, *from, id, true);
+        }
+        st->readahead.enabled = from->readahead.enabled;
+        return st;
+    }
+
+    SegmentTable* find(int asid) {
+        auto it = spaces.find(asid);
+        return it == spaces.end() ? nullptr : it->second.get();
+    }
+
+    bool switchTo(int asid) {
+        SegmentTable* st = find(asid);
+        if (st == nullptr) return false;
+        if (st != active) {
+            context_switches++;
+            if (flush_on_switch) tlb.flush();
+        }
+        active = st;
+        return true;
+    }
+
+    SegmentTable* current() { return active; }
+
+    // Translates in the current address space with the same results and
+    // side effects as SegmentTable::translate(); resident pages the TLB
+    // still vouches for skip the table walk.
+    int translate(int segNum, int pageDir, int pageNum, int offset, Protection accessType,
+                  int& latency, const char*& fault) {
+        if (active == nullptr) {
+            latency = 0;
+            fault = "Error: No address space scheduled";
+            return -1;
+        }
+        SegmentTable& st = *active;
+        TlbEntry& e = tlb.slot(st.asid, segNum, pageDir, pageNum);
+        bool tagged = e.asid == st.asid && e.seg == segNum && e.dir == pageDir && e.page == pageNum;
+
+        if (tagged) {
+            Page* p = e.pte;
+            bool write = accessType == READ_WRITE;
+            if (p->present && p->frame_number == e.frame) {
+                if (offset >= 0 && offset < e.page_size
+                    && !(write && (e.seg_read_only || p->protection == READ_ONLY || p->cow))) {
+                    uint64_t start = st.latency_profile ? wallNanos() : 0;
+                    tlb.hits++;
+                    memory.time++;
+                    latency = 1 + st.rng.uniform(5);
+                    fault = "OK";
+                    p->last_access_time = memory.time;
+                    memory.markChanged(e.frame);
+                    if (write) memory.recordWrite(*p, offset);
+                    if (p->prefetched) {
+                        p->prefetched = false;
+                        st.readahead.onPrefetchHit();
+                    }
+                    if (st.latency_profile) st.latency_profile->record(FAULT_NONE, latency, wallNanos() - start);
+                    return e.frame * e.page_size + offset;
+                }
+            } else {
+                tlb.stale++;
+            }
+        }
+        tlb.misses++;
+
+        int addr = st.translate(segNum, pageDir, pageNum, offset, accessType, latency, fault);
+        if (addr != -1) {
+            PageTable* pt = st.lookupPageTable(segNum, pageDir);
+            Page& p = pt->pages[pageNum];
+            e = {st.asid, segNum, pageDir, pageNum, &p, p.frame_number, pt->page_size,
+                 st.segments[segNum].protection == READ_ONLY};
+        }
+        return addr;
+    }
+
+    const std::map<int, std::unique_ptr<SegmentTable>>& addressSpaces() const { return spaces; }
+
+private:
+    std::map<int, std::unique_ptr<SegmentTable>> spaces;
+    SegmentTable* active = nullptr;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef ASYNC_LOG_HPP
+#define ASYNC_LOG_HPP
+
+// Moves results-log encoding and file writes off the translating thread.
+// The translation loop pushes fixed-size records into a single-producer,
+// single-consumer ring; a background thread drains it into a
+// ResultsLogWriter. When the ring is full the producer yields until the
+// writer catches up, so memory stays bounded however slow the disk is.
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "results_log.hpp"
+
+// Lock-free ring for exactly one pushing and one popping thread.
+// Capacity is rounded up to a power of two.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        slots.resize(cap);
+        mask = cap - 1;
+    }
+
+    bool tryPush(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head_cache == slots.size()) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t - head_cache == slots.size()) return false;
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail_cache) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) return false;
+        }
+        item = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: blocks until the producer publishes past `seen`
+    void waitForPush(size_t seen) const { tail.wait(seen, std::memory_order_acquire); }
+    void notifyConsumer() { tail.notify_one(); }
+    size_t pushed() const { return tail.load(std::memory_order_acquire); }
+    // Items pushed and not yet popped; a snapshot, from either side
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0};
+    size_t tail_cache = 0; // consumer's last view of tail
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t head_cache = 0; // producer's last view of head
+};
+
+// The writer thread only starts if the file opened; check is_open() before
+// appending.
+class AsyncResultsLog {
+public:
+    explicit AsyncResultsLog(const std::string& filename, size_t capacity = 1 << 14)
+        : writer(filename), ring(capacity),
+          worker(writer.is_open() ? std::thread([this] { run(); }) : std::thread()) {}
+
+    ~AsyncResultsLog() {
+        if (worker.joinable()) finish("");
+    }
+
+    AsyncResultsLog(const AsyncResultsLog&) = delete;
+    AsyncResultsLog& operator=(const AsyncResultsLog&) = delete;
+
+    bool is_open() const { return writer.is_open(); }
+
+    void append(int time, const LogicalAddress& a, const TranslationResult& r) {
+        push({time, a, r, false});
+        if ((++pending & (NOTIFY_EVERY - 1)) == 0) ring.notifyConsumer();
+    }
+
+    // Drains every queued record, then appends the summary and closes the file
+    void finish(const std::string& summary) {
+        push({0, {}, {}, true});
+        ring.notifyConsumer();
+        worker.join();
+        writer.finish(summary);
+    }
+
+    long producerStalls() const { return stalls; }
+
+    size_t queued() const { return ring.size(); }
+
+private:
+    struct Record {
+        int time;
+        LogicalAddress addr;
+        TranslationResult result;
+        bool last; // pushed by finish(), after every real record
+    };
+
+    static const size_t NOTIFY_EVERY = 256;
+
+    ResultsLogWriter writer;
+    SpscRing<Record> ring;
+    long stalls = 0;    // producer only
+    size_t pending = 0; // producer only
+    std::thread worker;
+
+    // Backpressure: spin-yield until the writer frees a slot
+    void push(const Record& rec) {
+        while (!ring.tryPush(rec)) {
+            stalls++;
+            ring.notifyConsumer();
+            std::this_thread::yield();
+        }
+    }
+
+    void run() {
+        Record rec;
+        size_t seen = 0;
+        for (;;) {
+            while (ring.tryPop(rec)) {
+                if (rec.last) return;
+                writer.append(rec.time, rec.addr, rec.result);
+                seen++;
+            }
+            ring.waitForPush(seen);
+        }
+    }
+};
+
+#endif
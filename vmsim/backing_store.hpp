@@ -0,0 +1,460 @@
+#ifndef BACKING_STORE_HPP
+#define BACKING_STORE_HPP
+
+// Optional swap device for a PhysicalMemory. Frames get real contents in a
+// num_frames * page_size buffer; an evicted page is written to its slot in
+// a swap file with pwrite() and read back with pread() when it faults in
+// again, so the wall-clock fault cost includes real I/O. A page that was
+// never swapped out starts with seeded contents (see fillPage()) and every
+// write access stores into its frame, so what gets swapped and compressed
+// changes as the simulation runs. A clean page, read back from its slot and
+// not written since, is dropped on eviction instead of written again.
+//
+// Two slot layouts, to compare how placement affects I/O:
+//   SWAP_PACKED    slots handed out in order of first swap-out (freed slots
+//                  are reused), so the file only grows with what was evicted
+//   SWAP_BY_TABLE  each page table owns a contiguous run of slots, page i at
+//                  run + i, so neighbouring pages are neighbours on disk
+//
+// The swap file is scratch space: it is truncated on open and removed when
+// the store is destroyed. Attach with physMem->store = &store; the store
+// must outlive every SegmentTable using that memory.
+//
+// With useAsyncReads() page-ins go through a FaultIo engine instead of
+// pread(): the fault is decided and the frame mapped at once, so results
+// and simulated state stay exactly as with synchronous reads, while the
+// read itself stays in flight as later addresses translate. Up to
+// queue_depth reads overlap. Anything that touches a frame's bytes (its
+// eviction write-back, a copy-on-write copy, reusing the frame) first
+// waits for that frame's read; drain() waits for all of them.
+//
+// With useCompressedTier() evicted pages are first compressed (lz.hpp) into
+// an in-memory pool capped at max_bytes, like zswap: a re-fault on a page
+// still in the pool is a decompression instead of a file read. Pages that
+// do not shrink to 3/4 of a page go straight to the file, and when the
+// pool is full its oldest pages are written back to their slots.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <list>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "histogram.hpp"
+#include "fault_io.hpp"
+#include "lz.hpp"
+#include "rng.hpp"
+
+class PageTable;
+
+enum SwapLayout { SWAP_PACKED, SWAP_BY_TABLE };
+
+// Where swapIn() found a page's contents
+enum PageSource { PAGE_FILLED, PAGE_FROM_TIER, PAGE_FROM_SLOT };
+
+class BackingStore {
+public:
+    long swap_outs = 0;
+    long swap_ins = 0;
+    long first_fills = 0; // faults on pages with nothing swapped out yet
+    long clean_evictions = 0; // evicted pages whose slot already held them
+    long io_errors = 0;
+    long frame_waits = 0;   // frame accesses that had to wait for a read
+    int max_in_flight = 0;
+    LatencyHistogram write_ns;
+    LatencyHistogram read_ns; // asynchronous reads: queued to completed
+    // compressed tier
+    long tier_stores = 0;
+    long tier_hits = 0;
+    long tier_rejects = 0;    // pages that did not compress well enough
+    long tier_writebacks = 0; // pushed out of a full pool to the file
+    int64_t tier_bytes_in = 0;  // page bytes stored
+    int64_t tier_bytes_out = 0; // what they compressed to
+    LatencyHistogram decompress_ns;
+
+    // Simulated cost of a fault served from the compressed tier, instead
+    // of the 100 cycles of a page fault
+    static constexpr int TIER_HIT_LATENCY = 10;
+
+    BackingStore(const std::string& filename, int numFrames, int pSize, SwapLayout swapLayout = SWAP_PACKED)
+        : path(filename), page_size(pSize), layout(swapLayout),
+          memory((size_t)numFrames * pSize), pending(numFrames, 0), queued_at(numFrames, 0) {
+        fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    }
+
+    ~BackingStore() {
+        drain();
+        if (fd >= 0) {
+            close(fd);
+            unlink(path.c_str());
+        }
+    }
+
+    BackingStore(const BackingStore&) = delete;
+    BackingStore& operator=(const BackingStore&) = delete;
+
+    bool is_open() const { return fd >= 0; }
+
+    int pageSize() const { return page_size; }
+
+    // The frame's bytes; with asynchronous reads, call waitFrame() first
+    char* frameData(int frame) { return memory.data() + (size_t)frame * page_size; }
+
+    // Seed for the first-touch contents of pages; the same seed and the same
+    // accesses give the same bytes
+    void seedContents(uint64_t seed) { content_seed = seed; }
+
+    // A write access at offset: stores value there (moved back to fit a
+    // page), so the frame's contents change the way the program's would
+    void writeWord(int frame, int offset, uint64_t value) {
+        waitFrame(frame);
+        size_t n = std::min<size_t>(sizeof(value), page_size);
+        size_t at = std::min<size_t>((size_t)offset, page_size - n);
+        std::memcpy(frameData(frame) + at, &value, n);
+    }
+
+    // Sends page-ins through io with up to depth in flight; nullptr goes
+    // back to synchronous pread(). io must outlive the store.
+    void useAsyncReads(FaultIo* engine, int depth) {
+        drain();
+        io = engine;
+        queue_depth = std::max(depth, 1);
+    }
+
+    FaultIo* asyncReads() const { return io; }
+
+    int readsInFlight() const { return in_flight; }
+
+    // Keeps up to maxBytes of compressed evicted pages in memory; 0 turns
+    // the tier off, writing whatever it holds back to the file
+    void useCompressedTier(size_t maxBytes) {
+        scratch.resize(page_size);
+        pool_cap = maxBytes;
+        while (pool_bytes > pool_cap) writeBackOldest();
+    }
+
+    size_t compressedBytes() const { return pool_bytes; }
+
+    void waitFrame(int frame) {
+        if (!pending[frame]) return;
+        frame_waits++;
+        while (pending[frame]) retire(true);
+    }
+
+    void drain() {
+        while (in_flight > 0) retire(true);
+    }
+
+    // Frame contents -> the slot of (table, page), a table of tablePages
+    // pages; a clean page whose slot already holds them is just dropped
+    void swapOut(int frame, const PageTable* table, int page, int tablePages, bool dirty) {
+        if (!dirty && slotFor(table, page, tablePages, false) >= 0) {
+            clean_evictions++;
+            return;
+        }
+        waitFrame(frame);
+        if (pool_cap > 0 && compress(frameData(frame), table, page, tablePages)) return;
+        writeSlot(frameData(frame), table, page, tablePages);
+    }
+
+    // The page's swapped-out contents -> frame, or its first-touch
+    // contents. Only PAGE_FROM_SLOT leaves the page clean: the pool drops
+    // what it decompresses, so a tier hit has no up-to-date copy left.
+    PageSource swapIn(int frame, const PageTable* table, int page, int tablePages) {
+        waitFrame(frame);
+        char* data = frameData(frame);
+        if (!pool.empty() && decompress(data, table, page)) return PAGE_FROM_TIER;
+        int64_t slot = slotFor(table, page, tablePages, false);
+        if (slot >= 0 && io) {
+            pending[frame] = 1;
+            queued_at[frame] = wallNanos();
+            io->read((uint64_t)frame, fd, data, page_size, (off_t)slot * page_size);
+            max_in_flight = std::max(max_in_flight, ++in_flight);
+            retire(in_flight >= queue_depth);
+            return PAGE_FROM_SLOT;
+        }
+        if (slot >= 0) {
+            uint64_t start = wallNanos();
+            if (transfer(false, data, slot)) {
+                read_ns.record(wallNanos() - start);
+                swap_ins++;
+                return PAGE_FROM_SLOT;
+            }
+        }
+        fillPage(data, table, page);
+        first_fills++;
+        return PAGE_FILLED;
+    }
+
+    void copyFrame(int from, int to) {
+        waitFrame(from);
+        waitFrame(to);
+        std::memcpy(frameData(to), frameData(from), page_size);
+    }
+
+    // Frees every slot and pooled page of a page table that is going away
+    void release(const PageTable* table) {
+        auto first = pool.lower_bound({table, INT_MIN});
+        while (first != pool.end() && first->first.first == table) first = dropCompressed(first);
+        table_ids.erase(table);
+        auto it = tables.find(table);
+        if (it == tables.end()) return;
+        TableSlots& t = it->second;
+        if (layout == SWAP_BY_TABLE) {
+            free_runs.emplace((int)t.slot.size(), t.base);
+        } else {
+            for (int64_t s : t.slot) {
+                if (s >= 0) free_slots.push_back(s);
+            }
+        }
+        tables.erase(it);
+    }
+
+    int64_t fileSlots() const { return next_slot; }
+
+    void printStats(std::ostream& out) const {
+        double mib = 1024.0 * 1024.0;
+        out << "\n--- Swap (" << (layout == SWAP_PACKED ? "packed" : "by-table") << " layout) ---\n";
+        out << "Swap Outs: " << swap_outs << " (" << swap_outs * (double)page_size / mib << " MiB)\n";
+        out << "Clean Evictions: " << clean_evictions << " (not written)\n";
+        out << "Swap Ins: " << swap_ins << " (" << swap_ins * (double)page_size / mib << " MiB)\n";
+        out << "First-Touch Fills: " << first_fills << " (seeded synthetic contents)\n";
+        out << "Swap File Size: " << next_slot * (double)page_size / mib << " MiB\n";
+        out << "Write p50/p99 (ns): " << write_ns.percentile(0.5) << " / " << write_ns.percentile(0.99) << "\n";
+        out << "Read p50/p99 (ns): " << read_ns.percentile(0.5) << " / " << read_ns.percentile(0.99) << "\n";
+        if (io) {
+            out << "Async Reads: " << io->name() << ", queue depth " << queue_depth
+                << ", max in flight " << max_in_flight << ", frame waits " << frame_waits << "\n";
+        }
+        if (pool_cap > 0) {
+            long faults = tier_hits + swap_ins;
+            out << "Compressed Tier: " << pool_bytes / 1024.0 << " of " << pool_cap / 1024.0 << " KiB used, "
+                << pool.size() << " pages\n";
+            out << "Tier Stores: " << tier_stores << ", rejected " << tier_rejects
+                << ", written back " << tier_writebacks << "\n";
+            out << "Tier Hit Rate: " << (faults ? 100.0 * tier_hits / faults : 0.0) << "% ("
+                << tier_hits << " of " << faults << " swapped-out page faults)\n";
+            out << "Compression Ratio: " << (tier_bytes_out ? (double)tier_bytes_in / tier_bytes_out : 0.0) << ":1\n";
+            out << "Decompress p50/p99 (ns): " << decompress_ns.percentile(0.5) << " / "
+                << decompress_ns.percentile(0.99) << "\n";
+        }
+        if (io_errors) out << "I/O Errors: " << io_errors << "\n";
+    }
+
+private:
+    struct TableSlots {
+        int64_t base = -1;          // SWAP_BY_TABLE: first slot of the run
+        std::vector<int64_t> slot;  // per page; -1 until first swapped out
+    };
+
+    std::string path;
+    int fd = -1;
+    int page_size;
+    SwapLayout layout;
+    std::vector<char> memory;
+    uint64_t content_seed = 1;
+    std::unordered_map<const PageTable*, uint64_t> table_ids; // in order first filled
+    uint64_t next_table_id = 0;
+    std::unordered_map<const PageTable*, TableSlots> tables;
+    std::vector<int64_t> free_slots;
+    std::multimap<int, int64_t> free_runs; // run length -> base
+    int64_t next_slot = 0;
+
+    FaultIo* io = nullptr;
+    int queue_depth = 1;
+    int in_flight = 0;
+    std::vector<char> pending;        // per frame: a read into it is in flight
+    std::vector<uint64_t> queued_at;  // per frame: when that read was queued
+    std::vector<FaultIoCompletion> completions;
+
+    using PoolKey = std::pair<const PageTable*, int>; // (table, page)
+    struct Compressed {
+        std::vector<char> data;
+        int table_pages;
+        std::list<PoolKey>::iterator age;
+    };
+    std::map<PoolKey, Compressed> pool;
+    std::list<PoolKey> pool_order; // oldest first
+    size_t pool_bytes = 0;
+    size_t pool_cap = 0;
+    std::vector<char> scratch; // a page, for compressing and write-backs
+
+    // First-touch contents of (table, page), drawn from the content seed.
+    // A page is a run of 64-byte blocks, each either random (like already
+    // compressed or encrypted data), zeros, or a copy of a record the page
+    // repeats with a per-block counter (like arrays of small structs). The
+    // mix varies from page to page, so some pages compress well, some
+    // hardly at all.
+    void fillPage(char* data, const PageTable* table, int page) {
+        auto [known, added] = table_ids.try_emplace(table, next_table_id);
+        if (added) next_table_id++;
+        uint64_t id = known->second;
+        Rng gen(content_seed ^ ((id << 32 | (uint32_t)page) * 0x9E3779B97F4A7C15ull));
+        double random = gen.uniformReal() * gen.uniformReal();
+        double zeros = random + (1 - random) * gen.uniformReal() / 2;
+        uint64_t record[8];
+        for (uint64_t& w : record) {
+            int bits = (int)gen.uniform(64); // small fields to full words
+            w = gen() >> bits;
+        }
+        for (int at = 0; at < page_size; at += (int)sizeof(record)) {
+            uint64_t block[8];
+            double kind = gen.uniformReal();
+            for (int w = 0; w < 8; ++w) {
+                block[w] = kind < random ? gen() : kind < zeros ? 0 : record[w];
+            }
+            if (kind >= zeros) block[0] += (uint64_t)at;
+            std::memcpy(data + at, block, std::min<size_t>(sizeof(block), page_size - at));
+        }
+    }
+
+    // Page bytes -> the pool, making room by writing back its oldest pages;
+    // false if the page should go to the file instead
+    bool compress(const char* data, const PageTable* table, int page, int tablePages) {
+        int n = lzCompress(data, page_size, scratch.data(), page_size * 3 / 4);
+        if (n < 0 || (size_t)n > pool_cap) {
+            tier_rejects++;
+            return false;
+        }
+        // write-backs decompress into scratch, so take the block out first
+        std::vector<char> block(scratch.data(), scratch.data() + n);
+        auto old = pool.find({table, page});
+        if (old != pool.end()) dropCompressed(old);
+        while (pool_bytes + n > pool_cap) writeBackOldest();
+
+        pool_order.push_back({table, page});
+        Compressed& c = pool[{table, page}];
+        c.data = std::move(block);
+        c.table_pages = tablePages;
+        c.age = std::prev(pool_order.end());
+        pool_bytes += n;
+        tier_stores++;
+        tier_bytes_in += page_size;
+        tier_bytes_out += n;
+        return true;
+    }
+
+    // The pooled copy of (table, page) -> data, leaving the pool; false if
+    // there is none
+    bool decompress(char* data, const PageTable* table, int page) {
+        auto it = pool.find({table, page});
+        if (it == pool.end()) return false;
+        uint64_t start = wallNanos();
+        bool ok = lzDecompress(it->second.data.data(), (int)it->second.data.size(), data, page_size);
+        decompress_ns.record(wallNanos() - start);
+        dropCompressed(it);
+        if (!ok) {
+            io_errors++;
+            return false;
+        }
+        tier_hits++;
+        return true;
+    }
+
+    std::map<PoolKey, Compressed>::iterator dropCompressed(std::map<PoolKey, Compressed>::iterator it) {
+        pool_bytes -= it->second.data.size();
+        pool_order.erase(it->second.age);
+        return pool.erase(it);
+    }
+
+    void writeBackOldest() {
+        auto it = pool.find(pool_order.front());
+        Compressed& c = it->second;
+        if (lzDecompress(c.data.data(), (int)c.data.size(), scratch.data(), page_size)) {
+            writeSlot(scratch.data(), it->first.first, it->first.second, c.table_pages);
+            tier_writebacks++;
+        } else {
+            io_errors++;
+        }
+        dropCompressed(it);
+    }
+
+    void writeSlot(char* data, const PageTable* table, int page, int tablePages) {
+        int64_t slot = slotFor(table, page, tablePages, true);
+        uint64_t start = wallNanos();
+        if (!transfer(true, data, slot)) return;
+        write_ns.record(wallNanos() - start);
+        swap_outs++;
+    }
+
+    // Collects finished reads (waiting for one if wait); a failed read
+    // leaves a zeroed frame
+    void retire(bool wait) {
+        completions.clear();
+        io->reap(completions, wait);
+        uint64_t now = wallNanos();
+        for (const FaultIoCompletion& c : completions) {
+            int frame = (int)c.tag;
+            if (c.result != page_size) {
+                io_errors++;
+                std::memset(frameData(frame), 0, page_size);
+            } else {
+                read_ns.record(now - queued_at[frame]);
+                swap_ins++;
+            }
+            pending[frame] = 0;
+            in_flight--;
+        }
+    }
+
+    // Slot of (table, page); with assign, one is allocated if it has none.
+    // Returns -1 for a page that has never been swapped out.
+    int64_t slotFor(const PageTable* table, int page, int tablePages, bool assign) {
+        auto it = tables.find(table);
+        if (it == tables.end()) {
+            if (!assign) return -1;
+            it = tables.emplace(table, TableSlots()).first;
+            it->second.slot.assign(tablePages, -1);
+        }
+        TableSlots& t = it->second;
+        if (page < 0 || page >= (int)t.slot.size()) return -1;
+        if (t.slot[page] >= 0 || !assign) return t.slot[page];
+
+        if (layout == SWAP_BY_TABLE) {
+            if (t.base < 0) {
+                auto run = free_runs.find((int)t.slot.size());
+                if (run != free_runs.end()) {
+                    t.base = run->second;
+                    free_runs.erase(run);
+                } else {
+                    t.base = next_slot;
+                    next_slot += (int64_t)t.slot.size();
+                }
+            }
+            t.slot[page] = t.base + page;
+        } else if (!free_slots.empty()) {
+            t.slot[page] = free_slots.back();
+            free_slots.pop_back();
+        } else {
+            t.slot[page] = next_slot++;
+        }
+        return t.slot[page];
+    }
+
+    bool transfer(bool write, char* data, int64_t slot) {
+        off_t pos = (off_t)slot * page_size;
+        size_t done = 0;
+        while (done < (size_t)page_size) {
+            ssize_t n = write ? pwrite(fd, data + done, page_size - done, pos + done)
+                              : pread(fd, data + done, page_size - done, pos + done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                io_errors++;
+                return false;
+            }
+            done += (size_t)n;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,333 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream> 
+#include <vector>
+#include <memory>
+#include <iomanip>
+
+#include "drivers.hpp"
+#include "translate_simd.hpp"
+#include "trace.hpp"
+#include "async_log.hpp"
+#include "live_metrics.hpp"
+
+void loadConfigFromFile(SegmentTable& st, const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cout << "Error: Could not open config file " << filename << ". Using random init.\n";
+        return;
+    }
+    
+    std::string line;
+    int lineNum = 0;
+    while (std::getline(file, line)) {
+        lineNum++;
+        if (line.empty() || line[0] == '#') {
+            continue; 
+        }
+        
+        std::stringstream ss(line);
+        int segId, dirSize, tableSize, protInt;
+        
+        if (ss >> segId >> dirSize >> tableSize >> protInt) {
+            Protection prot = (protInt == 1) ? READ_WRITE : READ_ONLY;
+            st.addSegment(segId, 0, dirSize, prot, dirSize, tableSize);
+            std::cout << "Loaded segment " << segId << " from file.\n";
+        } else {
+            std::cout << "Warning: Skipping malformed line " << lineNum << " in config file.\n";
+        }
+    }
+    file.close();
+}
+
+
+// Translates addrs into the results log and prints the stress-test summary;
+// num is what the fault rate is taken over. False, translating nothing, if
+// the log cannot be opened.
+static bool runStressTest(SegmentTable& st, const std::vector<LogicalAddress>& addrs, int num,
+                          const std::string& logFile) {
+    AsyncResultsLog log(logFile);
+    if (!log.is_open()) {
+        std::cout << "Error: Could not open results log " << logFile << "\n";
+        return false;
+    }
+    VMSIM_INSTRUMENT_BEGIN();
+    int faults = 0;
+    long total_latency = 0;
+    int successful_translations = 0;
+
+    if (st.capture) {
+        st.capture->reserve(st.capture->size() + addrs.size());
+        for (const LogicalAddress& a : addrs) st.capture->push(a);
+    }
+
+    // every translation advances the clock by one; the log thread encodes
+    // one chunk while the next is translated
+    const size_t chunkSize = 4096;
+    std::vector<TranslationResult> results(chunkSize);
+    std::unique_ptr<LatencyProfile> profile;
+    if (latency_report) {
+        profile = std::make_unique<LatencyProfile>();
+        st.latency_profile = profile.get();
+    }
+    for (size_t i = 0; i < addrs.size(); i += chunkSize) {
+        size_t n = std::min(chunkSize, addrs.size() - i);
+        int startTime = st.physMem->time;
+        long evictions = st.physMem->evictions;
+        st.translateBatch(std::span<const LogicalAddress>(addrs.data() + i, n),
+                          std::span<TranslationResult>(results.data(), n));
+
+        for (size_t k = 0; k < n; ++k) {
+            const TranslationResult& r = results[k];
+            log.append(startTime + (int)k + 1, addrs[i + k], r);
+            if (r.physical_address == -1) {
+                faults++;
+            } else {
+                successful_translations++;
+                total_latency += r.latency;
+            }
+        }
+        if (st.live_metrics) {
+            st.live_metrics->addChunk(std::span<const TranslationResult>(results.data(), n),
+                                      st.physMem->evictions - evictions, *st.physMem);
+            st.live_metrics->log_queue_depth.store((int)log.queued(), std::memory_order_relaxed);
+        }
+    }
+    st.latency_profile = nullptr;
+    
+    // the same text goes to the console and to the end of the log
+    std::ostringstream summary;
+    summary << "\n--- Stress Test Metrics ---\n";
+    
+    double faultRate = (double)faults / num * 100;
+    summary << "Page Fault/Error Rate: " << faultRate << "%\n";
+
+    double avgLatency = (successful_translations > 0) ? (double)total_latency / successful_translations : 0;
+    summary << "Average Translation Latency: " << avgLatency << "\n";
+    
+    summary << "Final Memory Utilization: " << st.physMem->utilization() << "%\n";
+
+    if (st.readahead.enabled) {
+        st.readahead.printMetrics(summary, st.physMem->wasted_prefetches);
+    }
+    if (profile) profile->printSimulated(summary);
+
+    log.finish(summary.str());
+    std::cout << summary.str();
+    if (profile) profile->printWall(std::cout);
+    std::cout << "Results Log Stalls: " << log.producerStalls() << "\n";
+
+    VMSIM_INSTRUMENT_REPORT(std::cout);
+    return true;
+}
+
+bool generateRandomAddresses(SegmentTable& st, int num, double validRatio, const std::string& logFile) {
+    Rng gen = st.rng.split();
+    std::vector<LogicalAddress> addrs;
+    addrs.reserve(num);
+    for (int i = 0; i < num; ++i) {
+        int segNum, pageDir, pageNum, offset, access;
+        
+        segNum = gen.uniform(st.segments.size());
+        PageDirectory& dir = st.segment_directories[segNum];
+        pageDir = gen.uniform(dir.page_tables.size()); 
+        PageTable* pt = dir.getPageTable(pageDir);
+        if(!pt) continue; 
+        
+        pageNum = gen.uniform(pt->pages.size());
+        offset = gen.uniform(pt->page_size);
+        access = gen.uniform(2) ? READ_WRITE : READ_ONLY;
+        addrs.push_back({segNum, pageDir, pageNum, offset, (Protection)access});
+    }
+    return runStressTest(st, addrs, num, logFile);
+}
+
+bool generateWorkload(SegmentTable& st, Workload& workload, int num, const std::string& logFile) {
+    std::vector<LogicalAddress> addrs(num);
+    workload.generate(addrs);
+    std::cout << "Workload: " << workload.name() << "\n";
+    return runStressTest(st, addrs, num, logFile);
+}
+
+void processBatchFile(SegmentTable& st, const std::string& filename) {
+    Trace trace(st);
+    if (!trace.load(filename)) {
+        std::cout << "Error: Could not load batch file " << filename << ": " << trace.load_error << "\n";
+        return;
+    }
+    
+    std::cout << "\n--- Processing Batch File: " << filename << " ---\n";
+    VMSIM_INSTRUMENT_BEGIN();
+    int faults = 0;
+    long total_latency = 0;
+    int total_translations = (int)trace.size();
+
+    // one address at a time while printing, so fault diagnostics stay next to their line
+    const size_t chunkSize = verbose ? 1 : 4096;
+    TraceChunk chunk;
+    TranslationView view(st);
+    std::vector<TranslationResult> results(chunkSize);
+    std::unique_ptr<LatencyProfile> profile;
+    if (latency_report) {
+        profile = std::make_unique<LatencyProfile>();
+        st.latency_profile = profile.get();
+    }
+
+    for (size_t i = 0; i < trace.size(); i += chunkSize) {
+        size_t n = std::min(chunkSize, trace.size() - i);
+        trace.decode(i, n, chunk);
+        if (st.capture) {
+            for (size_t k = 0; k < n; ++k) {
+                st.capture->push(chunk.seg[k], chunk.dir[k], chunk.page[k], chunk.offset[k],
+                                 (Protection)chunk.access[k]);
+            }
+        }
+        int startTime = st.physMem->time;
+        long evictions = st.physMem->evictions;
+        translateColumns(st, view, chunk.columns(), std::span<TranslationResult>(results.data(), n));
+        if (st.live_metrics) {
+            st.live_metrics->addChunk(std::span<const TranslationResult>(results.data(), n),
+                                      st.physMem->evictions - evictions, *st.physMem);
+        }
+
+        for (size_t k = 0; k < n; ++k) {
+            const TranslationResult& r = results[k];
+            total_latency += r.latency;
+            if (r.physical_address == -1) {
+                faults++;
+            }
+            if (!verbose) continue;
+
+            std::string logicAddr = "(" + std::to_string(chunk.seg[k]) + "," + std::to_string(chunk.dir[k]) 
+                                  + "," + std::to_string(chunk.page[k]) + "," + std::to_string(chunk.offset[k]) + ")";
+            int time = startTime + (int)k + 1;
+            if (r.physical_address != -1) {
+                std::cout << "Time " << time << ": "
+                          << "Logical " << logicAddr
+                          << " -> Physical " << r.physical_address << " (Latency: " << r.latency << ")\n";
+            } else {
+                std::cout << "Time " << time << ": "
+                          << "Logical " << logicAddr
+                          << " -> FAULT (" << r.fault << ")" << " (Latency: " << r.latency << ")\n";
+            }
+        }
+    }
+
+    st.latency_profile = nullptr;
+
+    std::cout << "\n--- Batch Processing Summary ---\n";
+    std::cout << "Total Translations: " << total_translations << "\n";
+    std::cout << "Successful: " << (total_translations - faults) << "\n";
+    std::cout << "Faults/Errors: " << faults << "\n";
+    if (total_translations > 0) {
+        std::cout << "Success Rate: " << (double)(total_translations - faults) / total_translations * 100 << "%\n";
+        std::cout << "Average Latency: " << (double)total_latency / total_translations << "\n";
+    }
+    if (st.readahead.enabled) {
+        st.readahead.printMetrics(std::cout, st.physMem->wasted_prefetches);
+    }
+    if (profile) profile->print(std::cout);
+    printTraceSummary(std::cout, analyzeTrace(trace));
+    std::cout << "--------------------------------\n";
+    VMSIM_INSTRUMENT_REPORT(std::cout);
+}
+
+
+void initRandomSegments(SegmentTable& st, int numSegments) {
+    int dirSize = 4; 
+    int tableSize = 16;
+    std::cout << "Initializing segments with " << dirSize << " directory entries and " 
+              << tableSize << " page table entries.\n";
+
+    for (int i = 0; i < numSegments; ++i) {
+        int limit = dirSize;
+        Protection prot = st.rng.uniform(2) ? READ_ONLY : READ_WRITE;
+        st.addSegment(i, 0, limit, prot, dirSize, tableSize);
+    }
+}
+
+
+void simulateAddressSpaces(AddressSpaceManager& m, int num, int quantum) {
+    // a segment with page tables, and those tables by directory index
+    struct SegmentTables {
+        int seg;
+        std::vector<std::pair<int, PageTable*>> tables;
+    };
+    struct Tenant {
+        SegmentTable* st;
+        Rng gen;
+        std::vector<SegmentTables> segments; // what addresses are drawn from
+        long translations = 0;
+        long errors = 0;
+        long page_faults = 0;
+    };
+    std::vector<Tenant> tenants;
+    for (auto const& [asid, st] : m.addressSpaces()) {
+        Tenant t{st.get(), st->rng.split(), {}};
+        for (auto& [id, dir] : st->segment_directories) {
+            if (id < 0 || id >= (int)st->segments.size() || dir.page_tables.empty()) continue;
+            SegmentTables& s = t.segments.emplace_back(SegmentTables{id, {}});
+            for (auto& [idx, pt] : dir.page_tables) s.tables.push_back({idx, &pt});
+        }
+        if (!t.segments.empty()) tenants.push_back(std::move(t));
+    }
+    if (tenants.empty() || quantum <= 0) {
+        std::cout << "No address spaces to run.\n";
+        return;
+    }
+
+    int done = 0;
+    for (size_t turn = 0; done < num; ++turn) {
+        Tenant& t = tenants[turn % tenants.size()];
+        m.switchTo(t.st->asid);
+        long translations = t.translations, errors = t.errors, pageFaults = t.page_faults;
+        long evictions = m.memory.evictions;
+        long tlbHits = m.tlb.hits;
+        for (int k = 0; k < quantum && done < num; ++k, ++done) {
+            const SegmentTables& s = t.segments[t.gen.uniform(t.segments.size())];
+            auto [pageDir, pt] = s.tables[t.gen.uniform(s.tables.size())];
+            int segNum = s.seg;
+            int pageNum = t.gen.uniform(pt->pages.size());
+            int offset = t.gen.uniform(pt->page_size);
+            Protection access = t.gen.uniform(2) ? READ_WRITE : READ_ONLY;
+
+            int latency;
+            const char* fault;
+            int addr = m.translate(segNum, pageDir, pageNum, offset, access, latency, fault);
+            t.translations++;
+            if (addr == -1) {
+                t.errors++;
+            } else if (classifyFault(addr, fault) == FAULT_PAGE) {
+                t.page_faults++;
+            }
+        }
+        if (t.st->live_metrics) {
+            // the TLB is what answers hits here
+            t.st->live_metrics->addCounts(t.translations - translations, m.tlb.hits - tlbHits,
+                                          t.page_faults - pageFaults, t.errors - errors,
+                                          m.memory.evictions - evictions, m.memory);
+        }
+    }
+
+    std::cout << "\n--- Address Spaces ---\n";
+    std::cout << std::left << std::setw(6) << "ASID" << std::right << std::setw(14) << "Translations"
+              << std::setw(10) << "Errors" << std::setw(12) << "PageFaults" << std::setw(10) << "CoW"
+              << std::setw(10) << "Frames" << "\n";
+    for (const Tenant& t : tenants) {
+        int frames = 0;
+        for (auto& [id, dir] : t.st->segment_directories)
+            for (auto& [idx, pt] : dir.page_tables)
+                for (const Page& p : pt.pages) frames += p.present;
+        std::cout << std::left << std::setw(6) << t.st->asid << std::right << std::setw(14) << t.translations
+                  << std::setw(10) << t.errors << std::setw(12) << t.page_faults << std::setw(10) << t.st->cow_faults
+                  << std::setw(10) << frames << "\n";
+    }
+    long lookups = m.tlb.hits + m.tlb.misses;
+    std::cout << "Context Switches: " << m.context_switches << "\n";
+    std::cout << "TLB Hit Rate: " << (lookups ? (double)m.tlb.hits / lookups * 100 : 0) << "% ("
+              << m.tlb.hits << " hits, " << m.tlb.misses << " misses, " << m.tlb.stale << " stale)\n";
+    std::cout << "TLB Flushes: " << m.tlb.flushes << "\n";
+    std::cout << "Shared Page Mappings: " << m.memory.sharedMappings() << "\n";
+    std::cout << "Final Memory Utilization: " << m.memory.utilization() << "%\n";
+}
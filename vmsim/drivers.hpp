@@ -0,0 +1,36 @@
+#ifndef DRIVERS_HPP
+#define DRIVERS_HPP
+
+// Front-end helpers shared by the part programs: config loading, random
+// segment setup, batch replay and the random-address stress test. With
+// st.capture set, batch replay and the stress test append the addresses
+// they translate to that trace.
+
+#include <string>
+
+#include "vmsim.hpp"
+#include "address_space.hpp"
+#include "workload.hpp"
+
+// "segId dirSize tableSize prot(0=RO,1=RW)" per line, '#' comments
+void loadConfigFromFile(SegmentTable& st, const std::string& filename);
+
+// numSegments read-write/read-only segments of 4 directories x 16 pages
+void initRandomSegments(SegmentTable& st, int numSegments);
+
+// Replays a text or binary trace and prints a summary
+void processBatchFile(SegmentTable& st, const std::string& filename);
+
+// Translates num random valid-shape addresses into a binary results log
+// (see results_log.hpp; decode_results prints it as CSV); false if the log
+// cannot be opened
+bool generateRandomAddresses(SegmentTable& st, int num, double validRatio, const std::string& logFile);
+
+// The same stress test over num addresses drawn from workload
+bool generateWorkload(SegmentTable& st, Workload& workload, int num, const std::string& logFile);
+
+// Round-robin over every address space in m, quantum random accesses per
+// turn, num accesses in all; prints per-ASID faults and TLB behaviour
+void simulateAddressSpaces(AddressSpaceManager& m, int num, int quantum);
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef FAULT_IO_HPP
+#define FAULT_IO_HPP
+
+// Asynchronous page-in engines for BackingStore. Reads are queued with
+// read(), handed over in batches and collected with reap(); the tag comes
+// back with the result (bytes read, or -errno).
+//
+//   UringFaultIo       io_uring through the raw syscalls: queued reads go
+//                      to the submission ring and one io_uring_enter()
+//                      submits the whole batch; reads the kernel refuses
+//                      to take come back failed with -errno
+//   ThreadPoolFaultIo  worker threads running pread(), for kernels without
+//                      io_uring (or with it disabled)
+//
+// An engine is not thread-safe: one BackingStore drives it.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct FaultIoCompletion {
+    uint64_t tag;
+    int64_t result;
+};
+
+class FaultIo {
+public:
+    virtual ~FaultIo() = default;
+    virtual const char* name() const = 0;
+    // Queues a read of len bytes at pos in fd into buf
+    virtual void read(uint64_t tag, int fd, char* buf, size_t len, off_t pos) = 0;
+    // Appends finished reads to out. With wait, first submits anything
+    // still queued and blocks until at least one read has finished.
+    virtual void reap(std::vector<FaultIoCompletion>& out, bool wait) = 0;
+};
+
+class UringFaultIo : public FaultIo {
+public:
+    // Room for depth reads in flight; queued reads are submitted once batch
+    // of them have piled up, or on the next reap()
+    UringFaultIo(unsigned depth, unsigned batchSize) : batch(batchSize ? batchSize : 1) {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        ring_fd = (int)syscall(__NR_io_uring_setup, depth, &p);
+        if (ring_fd < 0) return;
+
+        sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sq_size = cq_size = std::max(sq_size, cq_size);
+
+        sq_ring = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        cq_ring = single ? sq_ring
+                         : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+        sqes = (io_uring_sqe*)mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                   ring_fd, IORING_OFF_SQES);
+        if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+            unmap();
+            return;
+        }
+
+        char* sq = (char*)sq_ring;
+        sq_tail = (unsigned*)(sq + p.sq_off.tail);
+        sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+        sq_array = (unsigned*)(sq + p.sq_off.array);
+        char* cq = (char*)cq_ring;
+        cq_head = (unsigned*)(cq + p.cq_off.head);
+        cq_tail = (unsigned*)(cq + p.cq_off.tail);
+        cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+        ready = true;
+    }
+
+    ~UringFaultIo() override { unmap(); }
+
+    UringFaultIo(const UringFaultIo&) = delete;
+    UringFaultIo& operator=(const UringFaultIo&) = delete;
+
+    bool ok() const { return ready; }
+
+    // Whether the kernel implements opcode; false on kernels older than the
+    // probe itself (5.6), which also predate IORING_OP_READ
+    bool supports(unsigned opcode) const {
+        if (!ready) return false;
+        const unsigned ops = 256;
+        std::vector<char> buf(sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = (io_uring_probe*)buf.data();
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, ops) < 0) return false;
+        return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    void read(uint64_t tag, int fd, char* buf, size_t len, off_t pos) override {
+        unsigned tail = *sq_tail;
+        unsigned index = tail & sq_mask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)buf;
+        sqe->len = (uint32_t)len;
+        sqe->off = (uint64_t)pos;
+        sqe->user_data = tag;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        unsubmitted.push_back(tag);
+        if (++queued >= batch) enter(0);
+    }
+
+    void reap(std::vector<FaultIoCompletion>& out, bool wait) override {
+        size_t before = out.size();
+        takeFailed(out);
+        collect(out);
+        if (wait && out.size() == before) {
+            enter(1);
+            takeFailed(out);
+            collect(out);
+        }
+    }
+
+private:
+    int ring_fd = -1;
+    bool ready = false;
+    unsigned batch;
+    unsigned queued = 0; // in the submission ring, not yet submitted
+    std::deque<uint64_t> unsubmitted;        // their tags, oldest first
+    std::vector<FaultIoCompletion> failed; // refused at submission, for the next reap()
+
+    void* sq_ring = MAP_FAILED;
+    void* cq_ring = MAP_FAILED;
+    size_t sq_size = 0, cq_size = 0, sqes_size = 0;
+    io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+    unsigned* sq_tail = nullptr;
+    unsigned sq_mask = 0;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    void enter(unsigned minComplete) {
+        unsigned flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+        while (true) {
+            long r = syscall(__NR_io_uring_enter, ring_fd, queued, minComplete, flags, nullptr, 0);
+            if (r >= 0) {
+                queued -= (unsigned)r;
+                unsubmitted.erase(unsubmitted.begin(), unsubmitted.begin() + r);
+                // a partial submit only happens if the kernel is short of
+                // memory; whatever is left goes with the next call
+                if (queued == 0 || minComplete == 0) return;
+                continue;
+            }
+            if (errno == EINTR) continue;
+            // the kernel took none of the queued entries: withdraw them
+            // from the ring and fail their reads, so nobody waits on them.
+            // Reads already submitted still complete through the ring.
+            if (queued > 0 && errno != EAGAIN && errno != EBUSY) {
+                __atomic_store_n(sq_tail, *sq_tail - queued, __ATOMIC_RELEASE);
+                for (uint64_t tag : unsubmitted) failed.push_back({tag, -(int64_t)errno});
+                unsubmitted.clear();
+                queued = 0;
+            }
+            return;
+        }
+    }
+
+    void takeFailed(std::vector<FaultIoCompletion>& out) {
+        out.insert(out.end(), failed.begin(), failed.end());
+        failed.clear();
+    }
+
+    void collect(std::vector<FaultIoCompletion>& out) {
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& c = cqes[head & cq_mask];
+            out.push_back({c.user_data, c.res});
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    void unmap() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+        if (cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_size);
+        if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_size);
+        if (ring_fd >= 0) close(ring_fd);
+        sqes = (io_uring_sqe*)MAP_FAILED;
+        sq_ring = cq_ring = MAP_FAILED;
+        ring_fd = -1;
+        ready = false;
+    }
+};
+
+class ThreadPoolFaultIo : public FaultIo {
+public:
+    explicit ThreadPoolFaultIo(int threads) {
+        for (int i = 0; i < std::max(threads, 1); ++i) workers.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPoolFaultIo() override {
+        {
+            std::lock_guard<std::mutex> g(lock);
+            stopping = true;
+        }
+        queued_cv.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    ThreadPoolFaultIo(const ThreadPoolFaultIo&) = delete;
+    ThreadPoolFaultIo& operator=(const ThreadPoolFaultIo&) = delete;
+
+    const char* name() const override { return "thread pool"; }
+
+    void read(uint64_t tag, int fd, char* buf, size_t len, off_t pos) override {
+        {
+            std::lock_guard<std::mutex> g(lock);
+            requests.push_back({tag, fd, buf, len, pos});
+        }
+        queued_cv.notify_one();
+    }
+
+    void reap(std::vector<FaultIoCompletion>& out, bool wait) override {
+        std::unique_lock<std::mutex> g(lock);
+        if (wait) done_cv.wait(g, [this] { return !done.empty(); });
+        out.insert(out.end(), done.begin(), done.end());
+        done.clear();
+    }
+
+private:
+    struct Request {
+        uint64_t tag;
+        int fd;
+        char* buf;
+        size_t len;
+        off_t pos;
+    };
+
+    std::mutex lock;
+    std::condition_variable queued_cv;
+    std::condition_variable done_cv;
+    std::deque<Request> requests;
+    std::vector<FaultIoCompletion> done;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    void work() {
+        std::unique_lock<std::mutex> g(lock);
+        while (true) {
+            queued_cv.wait(g, [this] { return stopping || !requests.empty(); });
+            if (requests.empty()) return;
+            Request r = requests.front();
+            requests.pop_front();
+            g.unlock();
+
+            int64_t got = 0;
+            while (got < (int64_t)r.len) {
+                ssize_t n = pread(r.fd, r.buf + got, r.len - got, r.pos + got);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    got = n < 0 ? -errno : got;
+                    break;
+                }
+                got += n;
+            }
+
+            g.lock();
+            done.push_back({r.tag, got});
+            done_cv.notify_one();
+        }
+    }
+};
+
+// io_uring if the kernel allows it, otherwise (or without allowUring) a
+// pool of pread() threads; depth is the most reads the caller keeps in flight
+inline std::unique_ptr<FaultIo> makeFaultIo(int depth, bool allowUring = true) {
+    depth = std::max(depth, 1);
+    if (allowUring) {
+        auto uring = std::make_unique<UringFaultIo>((unsigned)depth, (unsigned)std::max(depth / 4, 1));
+        if (uring->supports(IORING_OP_READ)) return uring;
+    }
+    return std::make_unique<ThreadPoolFaultIo>(std::min(depth, 8));
+}
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+// Latency distributions for translations, split by how each one ended.
+// LatencyHistogram is HDR-style: values below 32 get their own bucket and
+// every power of two above that is cut into 16 linear sub-buckets, so any
+// recorded value is reported within ~6% and record() is a clz and an add.
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 4;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+
+    static int bucketFor(uint64_t v) {
+        if (v < 2 * SUB_COUNT) return (int)v;
+        int e = 63 - __builtin_clzll(v) - SUB_BITS;
+        return e * SUB_COUNT + (int)(v >> e);
+    }
+
+    // Largest value that lands in bucket b
+    static uint64_t bucketHigh(int b) {
+        if (b < 2 * SUB_COUNT) return (uint64_t)b;
+        int e = b / SUB_COUNT - 1;
+        uint64_t top = (uint64_t)(b % SUB_COUNT + SUB_COUNT);
+        return ((top + 1) << e) - 1;
+    }
+
+    void record(uint64_t v) {
+        buckets[bucketFor(v)]++;
+        count++;
+        total += v;
+        if (v > max) max = v;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int b = 0; b < NUM_BUCKETS; ++b) buckets[b] += other.buckets[b];
+        count += other.count;
+        total += other.total;
+        if (other.max > max) max = other.max;
+    }
+
+    // Upper bound of the bucket holding the q-quantile (0 < q <= 1), capped at max
+    uint64_t percentile(double q) const {
+        if (count == 0) return 0;
+        uint64_t rank = (uint64_t)(q * count + 0.5);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < NUM_BUCKETS; ++b) {
+            seen += buckets[b];
+            if (seen >= rank) return bucketHigh(b) < max ? bucketHigh(b) : max;
+        }
+        return max;
+    }
+
+    double mean() const { return count ? (double)total / count : 0; }
+
+private:
+    uint64_t buckets[NUM_BUCKETS] = {};
+};
+
+enum FaultType {
+    FAULT_NONE,        // resident hit
+    FAULT_PAGE,        // page fault serviced by allocating a frame
+    FAULT_SEGMENT,     // invalid segment / missing directory
+    FAULT_PROTECTION,  // write to a read-only segment or page
+    FAULT_BOUNDS,      // bad directory index, page number or offset
+    FAULT_REPLACEMENT, // no frame could be allocated
+    FAULT_COW,         // write to a shared page serviced by copying its frame
+    FAULT_TYPE_COUNT
+};
+
+inline const char* faultTypeName(FaultType t) {
+    static const char* const names[FAULT_TYPE_COUNT] = {"hit", "page fault", "segmentation", "protection",
+                                                        "bounds", "replacement", "copy-on-write"};
+    return names[t];
+}
+
+// Reads the outcome of a translate() call from its result and fault message
+inline FaultType classifyFault(int physicalAddress, const char* fault) {
+    if (physicalAddress != -1) {
+        switch (fault[0]) {
+            case 'O': return FAULT_NONE;
+            case 'C': return FAULT_COW;
+        }
+        return FAULT_PAGE;
+    }
+    switch (fault[0]) {
+        case 'S': return FAULT_SEGMENT;
+        case 'E': return FAULT_REPLACEMENT;
+        case 'P': if (fault[1] == 'r') return FAULT_PROTECTION; break;
+    }
+    return FAULT_BOUNDS;
+}
+
+inline uint64_t wallNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Simulated and wall-clock latency per fault type. Attach one to a
+// SegmentTable to have every translation recorded; merge() combines
+// profiles from separate runs or threads.
+struct LatencyProfile {
+    LatencyHistogram simulated[FAULT_TYPE_COUNT];
+    LatencyHistogram wall[FAULT_TYPE_COUNT]; // nanoseconds
+
+    void record(FaultType t, int latency, uint64_t wallNs) {
+        simulated[t].record((uint64_t)latency);
+        wall[t].record(wallNs);
+    }
+
+    void merge(const LatencyProfile& other) {
+        for (int t = 0; t < FAULT_TYPE_COUNT; ++t) {
+            simulated[t].merge(other.simulated[t]);
+            wall[t].merge(other.wall[t]);
+        }
+    }
+
+    void print(std::ostream& out) const {
+        printSimulated(out);
+        printWall(out);
+    }
+
+    void printSimulated(std::ostream& out) const { printTable(out, "Simulated latency", simulated); }
+
+    // Varies run to run; keep it out of reproducible logs
+    void printWall(std::ostream& out) const { printTable(out, "Wall-clock latency (ns)", wall); }
+
+private:
+    static void printTable(std::ostream& out, const char* title, const LatencyHistogram* h) {
+        LatencyHistogram all;
+        for (int t = 0; t < FAULT_TYPE_COUNT; ++t) all.merge(h[t]);
+        if (all.count == 0) return;
+
+        out << "\n--- " << title << " ---\n";
+        out << std::left << std::setw(14) << "Type" << std::right << std::setw(10) << "Count"
+            << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+            << std::setw(10) << "p99.9" << std::setw(10) << "Max" << "\n";
+        for (int t = 0; t <= FAULT_TYPE_COUNT; ++t) {
+            const LatencyHistogram& s = (t < FAULT_TYPE_COUNT) ? h[t] : all;
+            if (s.count == 0) continue;
+            out << std::left << std::setw(14) << (t < FAULT_TYPE_COUNT ? faultTypeName((FaultType)t) : "all")
+                << std::right << std::setw(10) << s.count << std::setw(10) << s.percentile(0.5)
+                << std::setw(10) << s.percentile(0.9) << std::setw(10) << s.percentile(0.99)
+                << std::setw(10) << s.percentile(0.999) << std::setw(10) << s.max << "\n";
+        }
+    }
+};
+
+#endif
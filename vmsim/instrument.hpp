@@ -0,0 +1,208 @@
+#ifndef INSTRUMENT_HPP
+#define INSTRUMENT_HPP
+
+// Optional per-phase timing for the translation path. Build with
+// -DVMSIM_INSTRUMENT (CMake option VMSIM_INSTRUMENT) to record cycle counts
+// for each phase into log2 histograms, plus hardware counters from
+// perf_event_open where the kernel allows it. Without the define every
+// macro below expands to nothing.
+//
+// Phases nest (a translate includes its page walk, allocation and
+// setFrame), so each row is inclusive of the phases it calls.
+
+enum Phase {
+    PHASE_TRANSLATE, // SegmentTable::translate
+    PHASE_BATCH,     // translateBatch / translateColumns, whole call
+    PHASE_PAGE_WALK, // PageTable::getFrameNumber
+    PHASE_ALLOCATE,  // PhysicalMemory::allocateFrame, including eviction
+    PHASE_SET_FRAME, // PageTable::setFrame
+    PHASE_COUNT
+};
+
+#ifdef VMSIM_INSTRUMENT
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+inline const char* phaseName(Phase p) {
+    static const char* const names[PHASE_COUNT] = {"translate", "batch", "page walk", "allocate frame", "set frame"};
+    return names[p];
+}
+
+// rdtsc where available, steady_clock nanoseconds otherwise
+inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct PhaseStats {
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+    // bucket b holds samples in [2^(b-1), 2^b); the last also takes anything larger
+    uint64_t buckets[64] = {};
+
+    void record(uint64_t cycles) {
+        count++;
+        total += cycles;
+        if (cycles > max) max = cycles;
+        // a TSC that steps back after a migration wraps to a huge delta
+        buckets[cycles ? std::min(64 - __builtin_clzll(cycles), 63) : 0]++;
+    }
+
+    // Upper bound of the bucket holding the q-quantile, capped at max
+    uint64_t quantile(double q) const {
+        uint64_t rank = (uint64_t)(q * count);
+        uint64_t seen = 0;
+        for (int b = 0; b < 64; ++b) {
+            seen += buckets[b];
+            if (seen > rank) return std::min<uint64_t>(b ? (1ull << b) - 1 : 0, max);
+        }
+        return max;
+    }
+};
+
+// Per thread, so parallel simulations do not share counters
+inline thread_local PhaseStats phase_stats[PHASE_COUNT];
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase p) : phase(p), start(readCycles()) {}
+    ~PhaseTimer() { phase_stats[phase].record(readCycles() - start); }
+
+private:
+    Phase phase;
+    uint64_t start;
+};
+
+// Hardware counters for the calling thread, user space only
+class PerfCounters {
+public:
+    static const int NUM_EVENTS = 4;
+
+    PerfCounters() {
+#ifdef __linux__
+        const uint64_t configs[NUM_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                              PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < NUM_EVENTS; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int i = 0; i < NUM_EVENTS; ++i) {
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fds[i], &values[i], sizeof(values[i])) != sizeof(values[i])) fds[i] = -1;
+        }
+#endif
+    }
+
+    void print(std::ostream& out) const {
+        static const char* const names[NUM_EVENTS] = {"cycles", "instructions", "cache misses", "branch misses"};
+        for (int i = 0; i < NUM_EVENTS; ++i) {
+            out << "  " << std::left << std::setw(16) << names[i] << std::right;
+            if (fds[i] < 0) out << "unavailable\n";
+            else out << values[i] << "\n";
+        }
+    }
+
+private:
+    int fds[NUM_EVENTS] = {-1, -1, -1, -1};
+    uint64_t values[NUM_EVENTS] = {};
+};
+
+// Clears the phase histograms and starts the hardware counters; report()
+// stops the counters and prints both.
+class InstrumentSession {
+public:
+    InstrumentSession() {
+        for (auto& s : phase_stats) s = PhaseStats();
+        perf.start();
+    }
+
+    void report(std::ostream& out) {
+        perf.stop();
+        out << "\n--- Instrumentation (cycles per call) ---\n";
+        out << std::left << std::setw(16) << "Phase" << std::right << std::setw(10) << "Calls"
+            << std::setw(14) << "Total" << std::setw(10) << "Mean" << std::setw(10) << "p50<="
+            << std::setw(10) << "p99<=" << std::setw(12) << "Max" << "\n";
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            const PhaseStats& s = phase_stats[p];
+            if (s.count == 0) continue;
+            out << std::left << std::setw(16) << phaseName((Phase)p) << std::right
+                << std::setw(10) << s.count << std::setw(14) << s.total
+                << std::setw(10) << s.total / s.count << std::setw(10) << s.quantile(0.5)
+                << std::setw(10) << s.quantile(0.99) << std::setw(12) << s.max << "\n";
+        }
+        out << "Hardware counters:\n";
+        perf.print(out);
+    }
+
+private:
+    PerfCounters perf;
+};
+
+#define VMSIM_PHASE(p) PhaseTimer vmsim_phase_timer_(p)
+#define VMSIM_INSTRUMENT_BEGIN() InstrumentSession vmsim_instrument_session_
+#define VMSIM_INSTRUMENT_REPORT(out) vmsim_instrument_session_.report(out)
+
+#else
+
+#define VMSIM_PHASE(p) ((void)0)
+#define VMSIM_INSTRUMENT_BEGIN() ((void)0)
+#define VMSIM_INSTRUMENT_REPORT(out) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef LIVE_METRICS_HPP
+#define LIVE_METRICS_HPP
+
+// Live view of a long run. The translating threads fold each chunk of
+// results into LiveMetrics with relaxed atomic adds, one per counter per
+// chunk, so the translation path takes no lock. A MetricsExporter thread
+// samples the counters every interval and rewrites a stats file in the
+// Prometheus text format (write to PATH.tmp, then rename), which a
+// node_exporter textfile collector or a plain `watch cat` can pick up.
+//
+// Attach with st.live_metrics = &metrics; copyLayout() hands the pointer
+// on, so sweep and replay runs all feed the same counters. With several
+// runs in parallel the memory gauges are those of the run that reported
+// last.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+
+#include "vmsim.hpp"
+
+struct LiveMetrics {
+    std::atomic<uint64_t> translations{0};
+    std::atomic<uint64_t> hits{0};        // resident, no fault: a TLB-like hit
+    std::atomic<uint64_t> page_faults{0}; // serviced by allocating or copying a frame
+    std::atomic<uint64_t> errors{0};      // translations that returned -1
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<int> used_frames{0};
+    std::atomic<int> num_frames{0};
+    std::atomic<int> log_queue_depth{0};      // results-log records not yet written
+    std::atomic<int> swap_reads_in_flight{0};
+    std::atomic<int> replay_tasks_queued{0};
+
+    // Folds in one chunk of results; evicted is how many frames the chunk
+    // took from other pages
+    void addChunk(std::span<const TranslationResult> results, long evicted, const PhysicalMemory& mem) {
+        uint64_t hit = 0, fault = 0, error = 0;
+        for (const TranslationResult& r : results) {
+            FaultType t = classifyFault(r.physical_address, r.fault);
+            hit += t == FAULT_NONE;
+            fault += t == FAULT_PAGE || t == FAULT_COW;
+            error += r.physical_address == -1;
+        }
+        addCounts(results.size(), hit, fault, error, evicted, mem);
+    }
+
+    void addCounts(uint64_t n, uint64_t hit, uint64_t fault, uint64_t error, long evicted,
+                   const PhysicalMemory& mem) {
+        translations.fetch_add(n, std::memory_order_relaxed);
+        hits.fetch_add(hit, std::memory_order_relaxed);
+        page_faults.fetch_add(fault, std::memory_order_relaxed);
+        errors.fetch_add(error, std::memory_order_relaxed);
+        evictions.fetch_add((uint64_t)evicted, std::memory_order_relaxed);
+        used_frames.store(mem.used_frames, std::memory_order_relaxed);
+        num_frames.store(mem.num_frames, std::memory_order_relaxed);
+        if (mem.store) swap_reads_in_flight.store(mem.store->readsInFlight(), std::memory_order_relaxed);
+    }
+};
+
+class MetricsExporter {
+public:
+    MetricsExporter(const LiveMetrics& source, const std::string& filename, int intervalMs = 1000)
+        : metrics(source), path(filename), interval(std::chrono::milliseconds(std::max(intervalMs, 1))),
+          started(Clock::now()), last_time(started), worker([this] { run(); }) {}
+
+    // Writes a last sample, so the file ends with the final totals
+    ~MetricsExporter() {
+        {
+            std::lock_guard<std::mutex> g(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    long writeErrors() const { return write_errors.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const LiveMetrics& metrics;
+    std::string path;
+    Clock::duration interval;
+    Clock::time_point started;
+
+    // exporter thread only: the previous sample, for the rates
+    Clock::time_point last_time;
+    uint64_t last_translations = 0;
+    uint64_t last_faults = 0;
+    uint64_t last_evictions = 0;
+
+    std::atomic<long> write_errors{0};
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+
+    void run() {
+        std::unique_lock<std::mutex> g(lock);
+        while (!wake.wait_for(g, interval, [this] { return stopping; })) {
+            g.unlock();
+            write();
+            g.lock();
+        }
+        g.unlock();
+        write();
+    }
+
+    void write() {
+        uint64_t translations = metrics.translations.load(std::memory_order_relaxed);
+        uint64_t hits = metrics.hits.load(std::memory_order_relaxed);
+        uint64_t faults = metrics.page_faults.load(std::memory_order_relaxed);
+        uint64_t errors = metrics.errors.load(std::memory_order_relaxed);
+        uint64_t evictions = metrics.evictions.load(std::memory_order_relaxed);
+        int used = metrics.used_frames.load(std::memory_order_relaxed);
+        int frames = metrics.num_frames.load(std::memory_order_relaxed);
+
+        Clock::time_point now = Clock::now();
+        double seconds = std::chrono::duration<double>(now - last_time).count();
+        uint64_t done = translations - last_translations;
+        double perSecond = seconds > 0 ? done / seconds : 0;
+        double faultRatio = done ? (double)(faults - last_faults) / done : 0;
+        double evictionsPerSecond = seconds > 0 ? (evictions - last_evictions) / seconds : 0;
+        last_time = now;
+        last_translations = translations;
+        last_faults = faults;
+        last_evictions = evictions;
+
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::trunc);
+            if (!out.is_open()) {
+                write_errors.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            auto metric = [&](const char* name, const char* type, const char* help, auto value) {
+                out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n"
+                    << name << " " << value << "\n";
+            };
+            metric("vmsim_translations_total", "counter", "Addresses translated.", translations);
+            metric("vmsim_hits_total", "counter", "Translations of resident pages without a fault.", hits);
+            metric("vmsim_page_faults_total", "counter", "Faults serviced by allocating or copying a frame.",
+                   faults);
+            metric("vmsim_errors_total", "counter", "Translations that failed.", errors);
+            metric("vmsim_evictions_total", "counter", "Frames taken from resident pages.", evictions);
+            metric("vmsim_translations_per_second", "gauge", "Translation rate over the last interval.", perSecond);
+            metric("vmsim_page_fault_ratio", "gauge", "Page faults per translation over the last interval.",
+                   faultRatio);
+            metric("vmsim_evictions_per_second", "gauge", "Eviction rate over the last interval.",
+                   evictionsPerSecond);
+            metric("vmsim_hit_ratio", "gauge", "Resident hits per translation since the start.",
+                   translations ? (double)hits / translations : 0);
+            metric("vmsim_memory_utilization_ratio", "gauge", "Frames in use over frames.",
+                   frames ? (double)used / frames : 0);
+            metric("vmsim_results_log_queue_depth", "gauge", "Results-log records waiting for the writer.",
+                   metrics.log_queue_depth.load(std::memory_order_relaxed));
+            metric("vmsim_swap_reads_in_flight", "gauge", "Asynchronous swap reads not yet completed.",
+                   metrics.swap_reads_in_flight.load(std::memory_order_relaxed));
+            metric("vmsim_replay_tasks_queued", "gauge", "Replay chunks waiting for a worker.",
+                   metrics.replay_tasks_queued.load(std::memory_order_relaxed));
+            metric("vmsim_uptime_seconds", "gauge", "Seconds since the exporter started.",
+                   std::chrono::duration<double>(now - started).count());
+            if (!out) {
+                write_errors.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) write_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+#endif
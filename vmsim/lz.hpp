@@ -0,0 +1,153 @@
+#ifndef LZ_HPP
+#define LZ_HPP
+
+// Small LZ77 block compressor in the style of LZ4, for the compressed swap
+// tier. A block is a run of sequences, each:
+//   token          high nibble literal count, low nibble match length - 4
+//                  (15 in either means more length bytes follow)
+//   [length bytes] 255, 255, ..., n  added to the literal count
+//   literals
+//   offset         2 bytes little-endian, distance back to the match
+//   [length bytes] added to the match length
+// The last sequence is literals only. Matches are found through a hash of
+// the next 4 bytes; greedy, one candidate per position.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace lz_detail {
+
+constexpr int MIN_MATCH = 4;
+constexpr int HASH_BITS = 12;
+constexpr int MAX_OFFSET = 65535;
+constexpr int LAST_LITERALS = 5; // the end of a block is always literals
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint32_t hash4(const uint8_t* p) {
+    return (read32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Writes the 255-run for a length that overflowed its nibble
+inline bool putLength(uint8_t*& out, const uint8_t* end, int n) {
+    for (; n >= 255; n -= 255) {
+        if (out >= end) return false;
+        *out++ = 255;
+    }
+    if (out >= end) return false;
+    *out++ = (uint8_t)n;
+    return true;
+}
+
+inline bool getLength(const uint8_t*& in, const uint8_t* end, int& n) {
+    uint8_t b;
+    do {
+        if (in >= end) return false;
+        b = *in++;
+        n += b;
+    } while (b == 255);
+    return true;
+}
+
+}
+
+// Compresses n bytes of src into dst; returns the compressed size, or -1
+// if it would not fit in cap bytes.
+inline int lzCompress(const char* src, int n, char* dst, int cap) {
+    using namespace lz_detail;
+    const uint8_t* in = (const uint8_t*)src;
+    const uint8_t* inEnd = in + n;
+    uint8_t* out = (uint8_t*)dst;
+    const uint8_t* outEnd = out + cap;
+    int32_t table[1 << HASH_BITS];
+    for (int32_t& t : table) t = -1;
+
+    const uint8_t* anchor = in; // first literal not yet emitted
+    int pos = 0;
+    int matchLimit = n - LAST_LITERALS;
+
+    auto emit = [&](const uint8_t* literalEnd, int offset, int matchLen) {
+        int literals = (int)(literalEnd - anchor);
+        if (out >= outEnd) return false;
+        uint8_t* token = out++;
+        *token = (uint8_t)((literals >= 15 ? 15 : literals) << 4);
+        if (literals >= 15 && !putLength(out, outEnd, literals - 15)) return false;
+        if (literals > outEnd - out) return false;
+        if (literals > 0) std::memcpy(out, anchor, literals);
+        out += literals;
+        if (matchLen == 0) return true;
+
+        if (outEnd - out < 2) return false;
+        *out++ = (uint8_t)(offset & 0xFF);
+        *out++ = (uint8_t)(offset >> 8);
+        int extra = matchLen - MIN_MATCH;
+        *token |= (uint8_t)(extra >= 15 ? 15 : extra);
+        if (extra >= 15 && !putLength(out, outEnd, extra - 15)) return false;
+        return true;
+    };
+
+    while (pos + MIN_MATCH <= matchLimit) {
+        const uint8_t* p = in + pos;
+        uint32_t h = hash4(p);
+        int32_t candidate = table[h];
+        table[h] = pos;
+        if (candidate < 0 || pos - candidate > MAX_OFFSET || read32(in + candidate) != read32(p)) {
+            pos++;
+            continue;
+        }
+
+        int len = MIN_MATCH;
+        while (pos + len < matchLimit && in[candidate + len] == p[len]) len++;
+        if (!emit(p, pos - candidate, len)) return -1;
+        pos += len;
+        anchor = in + pos;
+    }
+    if (!emit(inEnd, 0, 0)) return -1;
+    return (int)(out - (uint8_t*)dst);
+}
+
+// Decompresses a block into exactly outSize bytes; false if the block is
+// malformed or does not decode to that size.
+inline bool lzDecompress(const char* src, int n, char* dst, int outSize) {
+    using namespace lz_detail;
+    const uint8_t* in = (const uint8_t*)src;
+    const uint8_t* inEnd = in + n;
+    uint8_t* out = (uint8_t*)dst;
+    uint8_t* outEnd = out + outSize;
+
+    while (in < inEnd) {
+        uint8_t token = *in++;
+        int literals = token >> 4;
+        if (literals == 15 && !getLength(in, inEnd, literals)) return false;
+        if (literals > inEnd - in || literals > outEnd - out) return false;
+        if (literals > 0) std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == inEnd) break; // final literals-only sequence
+
+        if (inEnd - in < 2) return false;
+        int offset = in[0] | (in[1] << 8);
+        in += 2;
+        int len = (token & 15);
+        if (len == 15 && !getLength(in, inEnd, len)) return false;
+        len += MIN_MATCH;
+        if (offset == 0 || offset > out - (uint8_t*)dst || len > outEnd - out) return false;
+        // A match closer than its length repeats the offset bytes before it;
+        // copy whole periods, doubling what is available each round
+        const uint8_t* from = out - offset;
+        for (int done = 0; done < len;) {
+            int n = std::min(offset + done, len - done);
+            std::memcpy(out + done, from, n);
+            done += n;
+        }
+        out += len;
+    }
+    return out == outEnd;
+}
+
+#endif
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "replay.hpp"
+#include "live_metrics.hpp"
+
+void copyLayout(const SegmentTable& from, SegmentTable& to) {
+    to.segments = from.segments;
+    for (auto const& [id, dir] : from.segment_directories) {
+        PageDirectory& copy = to.segment_directories[id];
+        copy.page_table_size = dir.page_table_size;
+        for (auto const& [idx, pt] : dir.page_tables) {
+            PageTable& table = copy.page_tables.try_emplace(idx, to.page_size, pt.pages).first->second;
+            // from's frames mean nothing in to's memory
+            for (int p = 0; p < (int)table.pages.size(); ++p) table.invalidatePage(p);
+        }
+    }
+    to.rng = from.rng;
+    to.readahead.enabled = from.readahead.enabled;
+    to.live_metrics = from.live_metrics;
+}
+
+static SegmentTable& withLayout(SegmentTable& st, const SegmentTable& layout) {
+    copyLayout(layout, st);
+    return st;
+}
+
+ReplayRun::ReplayRun(const SegmentTable& layout, const SweepConfig& config)
+    : st(config.num_frames, config.page_size, config.algo), view(withLayout(st, layout)), results(4096) {
+    res.config = config;
+}
+
+bool ReplayRun::step(const Trace& trace, size_t maxAccesses) {
+    auto start = std::chrono::steady_clock::now();
+    size_t end = std::min(trace.size(), position + maxAccesses);
+    while (position < end) {
+        size_t n = std::min(results.size(), end - position);
+        trace.decode(position, n, chunk);
+        long evictions = st.physMem->evictions;
+        translateColumns(st, view, chunk.columns(), std::span<TranslationResult>(results.data(), n));
+        if (st.live_metrics) {
+            st.live_metrics->addChunk(std::span<const TranslationResult>(results.data(), n),
+                                      st.physMem->evictions - evictions, *st.physMem);
+        }
+
+        for (size_t k = 0; k < n; ++k) {
+            const TranslationResult& r = results[k];
+            latency.record((uint64_t)r.latency);
+            if (r.physical_address == -1) {
+                res.errors++;
+            } else if (classifyFault(r.physical_address, r.fault) == FAULT_PAGE) {
+                res.page_faults++;
+            }
+        }
+        position += n;
+    }
+    res.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return position == trace.size();
+}
+
+SweepResult ReplayRun::result() const {
+    SweepResult r = res;
+    r.translations = (long)position;
+    r.avg_latency = latency.mean();
+    r.p99_latency = latency.percentile(0.99);
+    r.utilization = st.physMem->utilization();
+    return r;
+}
+
+namespace {
+
+// The owner pushes and pops at the back; a thief takes the queued task with
+// the most accesses left, wherever it sits
+struct alignas(64) WorkerQueue {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+
+    void push(size_t job) {
+        std::lock_guard<std::mutex> g(lock);
+        tasks.push_back(job);
+    }
+
+    // Where the owner will reach it last, for a waiting thief
+    void pushFront(size_t job) {
+        std::lock_guard<std::mutex> g(lock);
+        tasks.push_front(job);
+    }
+
+    bool pop(size_t& job) {
+        std::lock_guard<std::mutex> g(lock);
+        if (tasks.empty()) return false;
+        job = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+
+    template <typename Left>
+    bool steal(size_t& job, Left left) {
+        std::lock_guard<std::mutex> g(lock);
+        if (tasks.empty()) return false;
+        auto best = std::max_element(tasks.begin(), tasks.end(),
+                                     [&](size_t a, size_t b) { return left(a) < left(b); });
+        job = *best;
+        tasks.erase(best);
+        return true;
+    }
+};
+
+// A job's chunks run one at a time (the continuation is queued only after
+// the previous chunk returns), so its state needs no lock of its own; the
+// queue lock orders one chunk's writes before the next chunk's reads.
+struct JobState {
+    std::unique_ptr<ReplayRun> run;
+    const Trace* trace = nullptr; // shared by every job on the same path
+    size_t left = 0;              // accesses not yet replayed
+    ReplayJobResult out;
+    std::vector<char> ran_on; // per worker
+};
+
+}
+
+std::vector<ReplayJobResult> replayTraces(const SegmentTable& layout, const std::vector<ReplayJob>& jobs,
+                                          int numThreads, size_t chunkAccesses,
+                                          std::vector<WorkerStats>& workerStats) {
+    if (numThreads <= 0) numThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::max(1, std::min<int>(numThreads, (int)jobs.size()));
+    chunkAccesses = std::max<size_t>(chunkAccesses, 1);
+
+    // Each distinct trace is loaded once, in parallel, and shared read-only
+    // by the configurations replaying it
+    std::map<std::string, size_t> traceIndex;
+    std::vector<std::string> paths;
+    for (const ReplayJob& job : jobs) {
+        if (traceIndex.try_emplace(job.trace_path, paths.size()).second) paths.push_back(job.trace_path);
+    }
+    std::vector<Trace> traces(paths.size(), Trace(layout));
+    std::vector<char> loaded(paths.size(), 0);
+    {
+        std::atomic<size_t> next{0};
+        auto load = [&] {
+            for (size_t t; (t = next.fetch_add(1)) < paths.size();) loaded[t] = traces[t].load(paths[t]);
+        };
+        std::vector<std::thread> loaders;
+        for (int w = 1; w < std::min<int>(numThreads, (int)paths.size()); ++w) loaders.emplace_back(load);
+        load();
+        for (std::thread& t : loaders) t.join();
+    }
+
+    std::vector<JobState> state(jobs.size());
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        size_t t = traceIndex[jobs[j].trace_path];
+        JobState& js = state[j];
+        js.out.trace_path = jobs[j].trace_path;
+        js.out.stats.config = jobs[j].config;
+        js.out.loaded = loaded[t];
+        js.out.load_error = traces[t].load_error;
+        js.trace = &traces[t];
+        js.left = loaded[t] ? traces[t].size() : 0;
+        js.ran_on.assign(numThreads, 0);
+    }
+
+    // Deal the longest jobs first, each worker starting on its longest
+    std::vector<size_t> order(jobs.size());
+    for (size_t j = 0; j < order.size(); ++j) order[j] = j;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return state[a].left > state[b].left; });
+
+    std::vector<WorkerQueue> queues(numThreads);
+    for (size_t i = order.size(); i-- > 0;) {
+        queues[i % numThreads].push(order[i]);
+    }
+    LiveMetrics* live = layout.live_metrics;
+    if (live) live->replay_tasks_queued.store((int)jobs.size(), std::memory_order_relaxed);
+
+    // Runs one chunk of job j on worker w; true if the job has more to do
+    auto runChunk = [&](size_t j, int w) {
+        JobState& js = state[j];
+        js.out.chunks++;
+        js.ran_on[w] = 1;
+        bool finished = true;
+        if (js.out.loaded) {
+            if (!js.run) js.run = std::make_unique<ReplayRun>(layout, jobs[j].config);
+            finished = js.run->step(*js.trace, chunkAccesses);
+            js.left = finished ? 0 : js.left - std::min(js.left, chunkAccesses);
+        }
+        if (!finished) return true;
+
+        if (js.run) js.out.stats = js.run->result();
+        js.out.workers_used = (int)std::count(js.ran_on.begin(), js.ran_on.end(), 1);
+        js.run.reset();
+        return false;
+    };
+    auto left = [&](size_t j) { return state[j].left; };
+
+    using Clock = std::chrono::steady_clock;
+    workerStats.assign(numThreads, WorkerStats());
+
+    // Idle workers sleep until a task is queued or every job is done
+    std::mutex idleLock;
+    std::condition_variable idleWake;
+    size_t remaining = jobs.size(); // under idleLock
+    size_t queued = jobs.size();    // tasks in any queue; under idleLock
+    int sleeping = 0;               // under idleLock
+
+    auto worker = [&](int w) {
+        WorkerStats& ws = workerStats[w];
+        Rng rng(w + 1);
+
+        while (true) {
+            size_t j;
+            bool stolen = false;
+            bool found = queues[w].pop(j);
+            if (!found && numThreads > 1) {
+                int first = (int)rng.uniform(numThreads - 1);
+                for (int k = 0; k < numThreads - 1 && !found; ++k) {
+                    int victim = (w + 1 + (first + k) % (numThreads - 1)) % numThreads;
+                    found = queues[victim].steal(j, left);
+                }
+                stolen = found;
+            }
+
+            if (!found) {
+                ws.failed_steals++;
+                Clock::time_point idleSince = Clock::now();
+                std::unique_lock<std::mutex> g(idleLock);
+                if (remaining == 0) break;
+                sleeping++;
+                idleWake.wait(g, [&] { return queued > 0 || remaining == 0; });
+                sleeping--;
+                ws.idle_seconds += std::chrono::duration<double>(Clock::now() - idleSince).count();
+                if (remaining == 0) break;
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> g(idleLock);
+                queued--;
+            }
+            Clock::time_point start = Clock::now();
+            if (stolen) ws.steals++;
+            ws.tasks++;
+            if (live) live->replay_tasks_queued.fetch_sub(1, std::memory_order_relaxed);
+
+            bool more = runChunk(j, w);
+            ws.busy_seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            if (more) {
+                // with a worker waiting, hand the continuation over and move
+                // on to our next task, so one long trace does not hold up
+                // the rest of this queue
+                bool handOff, wake;
+                {
+                    std::lock_guard<std::mutex> g(idleLock);
+                    handOff = sleeping > 0;
+                }
+                if (handOff) queues[w].pushFront(j);
+                else queues[w].push(j);
+                if (live) live->replay_tasks_queued.fetch_add(1, std::memory_order_relaxed);
+                {
+                    std::lock_guard<std::mutex> g(idleLock);
+                    queued++;
+                    wake = sleeping > 0;
+                }
+                if (wake) idleWake.notify_one();
+            } else {
+                bool last;
+                {
+                    std::lock_guard<std::mutex> g(idleLock);
+                    last = --remaining == 0;
+                }
+                if (last) idleWake.notify_all();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int w = 1; w < numThreads; ++w) pool.emplace_back(worker, w);
+    worker(0);
+    for (std::thread& t : pool) t.join();
+
+    std::vector<ReplayJobResult> results;
+    results.reserve(jobs.size());
+    for (JobState& js : state) results.push_back(std::move(js.out));
+    return results;
+}
+
+void writeReplayCsv(std::ostream& out, const std::vector<ReplayJobResult>& results) {
+    out << "Trace," << SWEEP_CSV_COLUMNS << ",Chunks,Workers\n";
+    for (const ReplayJobResult& r : results) {
+        out << r.trace_path << ",";
+        writeSweepFields(out, r.stats);
+        out << "," << r.chunks << "," << r.workers_used << "\n";
+    }
+}
+
+void printWorkerStats(std::ostream& out, const std::vector<WorkerStats>& stats) {
+    out << "\n--- Replay Workers ---\n";
+    out << std::left << std::setw(8) << "Worker" << std::right << std::setw(10) << "Tasks"
+        << std::setw(10) << "Steals" << std::setw(14) << "EmptyRounds" << std::setw(12) << "Busy(s)"
+        << std::setw(12) << "Idle(s)" << "\n";
+    for (size_t w = 0; w < stats.size(); ++w) {
+        const WorkerStats& s = stats[w];
+        out << std::left << std::setw(8) << w << std::right << std::setw(10) << s.tasks
+            << std::setw(10) << s.steals << std::setw(14) << s.failed_steals
+            << std::setw(12) << s.busy_seconds << std::setw(12) << s.idle_seconds << "\n";
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+// Multi-trace replay. Every (trace, configuration) pair is a job that is
+// replayed in fixed-size chunks; each chunk is one task on a work-stealing
+// pool. A job that is not finished requeues its continuation on the worker
+// that ran it, which picks it up again next unless another worker is
+// waiting: then the continuation is left for the thief. Thieves take the
+// queued task with the most accesses left from a random victim, and sleep
+// while nothing is queued, so uneven trace lengths do not leave cores idle.
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "vmsim.hpp"
+#include "trace.hpp"
+#include "translate_simd.hpp"
+#include "sweep.hpp"
+
+// Same segments, directories and page protections as from, sized for to's
+// page size, with nothing resident; also copies the RNG, readahead switch
+// and live metrics
+void copyLayout(const SegmentTable& from, SegmentTable& to);
+
+// One trace replaying under one configuration, resumable between chunks
+class ReplayRun {
+public:
+    ReplayRun(const SegmentTable& layout, const SweepConfig& config);
+
+    // Replays up to maxAccesses more accesses; true once the trace is done
+    bool step(const Trace& trace, size_t maxAccesses);
+
+    SweepResult result() const;
+
+    SegmentTable st;
+
+private:
+    TranslationView view;
+    TraceChunk chunk;
+    std::vector<TranslationResult> results;
+    LatencyHistogram latency;
+    SweepResult res;
+    size_t position = 0;
+};
+
+struct ReplayJob {
+    std::string trace_path;
+    SweepConfig config;
+};
+
+struct ReplayJobResult {
+    std::string trace_path;
+    bool loaded = false;
+    const char* load_error = nullptr; // why the trace did not load
+    SweepResult stats;
+    int chunks = 0;
+    int workers_used = 0; // distinct workers that ran one of its chunks
+};
+
+struct WorkerStats {
+    long tasks = 0;         // chunks executed
+    long steals = 0;        // tasks taken from another worker
+    long failed_steals = 0; // rounds over every victim that found nothing
+    double busy_seconds = 0;
+    double idle_seconds = 0;
+};
+
+// Replays every job on numThreads workers (0: one per core), chunkAccesses
+// accesses per task. Each distinct trace path is loaded once, up front and
+// in parallel, and shared by its jobs; results come back in job order.
+std::vector<ReplayJobResult> replayTraces(const SegmentTable& layout, const std::vector<ReplayJob>& jobs,
+                                          int numThreads, size_t chunkAccesses,
+                                          std::vector<WorkerStats>& workerStats);
+
+void writeReplayCsv(std::ostream& out, const std::vector<ReplayJobResult>& results);
+void printWorkerStats(std::ostream& out, const std::vector<WorkerStats>& stats);
+
+#endif
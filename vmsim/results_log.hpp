@@ -0,0 +1,205 @@
+#ifndef RESULTS_LOG_HPP
+#define RESULTS_LOG_HPP
+
+// Compact binary log of per-access translation results, written by the
+// random-address stress test in place of the old CSV. decode_results turns
+// it back into the CSV (Time,LogicalAddress,Access,Status,PhysicalAddress,
+// Latency) followed by the metrics summary.
+//
+// Format: "VMRL", version byte, then one record per access:
+//   flags byte   bit0 write, bit1 fault, bit2 fault text defined here
+//   time         zigzag varint, delta from the previous record
+//   seg dir page offset   zigzag varints
+//   fault        varint id (+ varint length and bytes the first time), or
+//   physical     zigzag varint
+//   latency      zigzag varint
+// A flags byte of 0x80 ends the records and is followed by the summary text
+// as a varint length and bytes.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "vmsim.hpp"
+
+struct ResultRecord {
+    int time = 0;
+    LogicalAddress addr{};
+    int physical_address = -1;
+    int latency = 0;
+    std::string fault;
+};
+
+class ResultsLogWriter {
+public:
+    explicit ResultsLogWriter(const std::string& filename) : file(filename, std::ios::binary) {
+        buf.reserve(BUFFER_SIZE + 64);
+        buf.insert(buf.end(), MAGIC, MAGIC + 4);
+        buf.push_back(VERSION);
+    }
+
+    ~ResultsLogWriter() {
+        if (!finished) finish("");
+    }
+
+    ResultsLogWriter(const ResultsLogWriter&) = delete;
+    ResultsLogWriter& operator=(const ResultsLogWriter&) = delete;
+
+    bool is_open() const { return file.is_open(); }
+
+    void append(int time, const LogicalAddress& a, const TranslationResult& r) {
+        bool isFault = r.physical_address == -1;
+        int faultId = -1;
+        bool define = false;
+        if (isFault) {
+            faultId = faultIdFor(r.fault, define);
+        }
+
+        buf.push_back((uint8_t)((a.access == READ_WRITE ? 1 : 0) | (isFault ? 2 : 0) | (define ? 4 : 0)));
+        putSigned((int64_t)time - last_time);
+        last_time = time;
+        putSigned(a.segNum);
+        putSigned(a.pageDir);
+        putSigned(a.pageNum);
+        putSigned(a.offset);
+        if (isFault) {
+            putVarint((uint64_t)faultId);
+            if (define) putString(r.fault, std::strlen(r.fault));
+        } else {
+            putSigned(r.physical_address);
+        }
+        putSigned(r.latency);
+
+        if (buf.size() >= BUFFER_SIZE) flush();
+    }
+
+    // Ends the record stream and appends the metrics text
+    void finish(const std::string& summary) {
+        buf.push_back(END);
+        putString(summary.data(), summary.size());
+        flush();
+        file.close();
+        finished = true;
+    }
+
+    static constexpr const char MAGIC[4] = {'V', 'M', 'R', 'L'};
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t END = 0x80;
+
+private:
+    static const size_t BUFFER_SIZE = 1 << 16;
+
+    std::ofstream file;
+    std::vector<uint8_t> buf;
+    std::vector<const char*> faults; // id -> first message seen with that text
+    int last_time = 0;
+    bool finished = false;
+
+    // Fault messages are string literals, so a pointer match almost always
+    // hits; the strcmp keeps equal text from different literals on one id.
+    int faultIdFor(const char* fault, bool& define) {
+        for (size_t i = 0; i < faults.size(); ++i) {
+            if (faults[i] == fault || std::strcmp(faults[i], fault) == 0) return (int)i;
+        }
+        faults.push_back(fault);
+        define = true;
+        return (int)faults.size() - 1;
+    }
+
+    void putVarint(uint64_t v) {
+        while (v >= 0x80) {
+            buf.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        buf.push_back((uint8_t)v);
+    }
+
+    void putSigned(int64_t v) { putVarint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63)); }
+
+    void putString(const char* s, size_t len) {
+        putVarint(len);
+        buf.insert(buf.end(), s, s + len);
+    }
+
+    void flush() {
+        file.write((const char*)buf.data(), (std::streamsize)buf.size());
+        buf.clear();
+    }
+};
+
+class ResultsLogReader {
+public:
+    // False if the file is missing or not a results log
+    bool open(const std::string& filename) {
+        file.open(filename, std::ios::binary);
+        char magic[4];
+        if (!file.read(magic, 4) || std::memcmp(magic, ResultsLogWriter::MAGIC, 4) != 0) return false;
+        return file.get() == ResultsLogWriter::VERSION;
+    }
+
+    // Next record, or false at the end of the stream (summary() is then set)
+    bool next(ResultRecord& rec) {
+        int flags = file.get();
+        if (flags == std::char_traits<char>::eof()) return false;
+        if (flags == ResultsLogWriter::END) {
+            summary_text = getString();
+            return false;
+        }
+
+        last_time += (int)getSigned();
+        rec.time = last_time;
+        rec.addr.segNum = (int)getSigned();
+        rec.addr.pageDir = (int)getSigned();
+        rec.addr.pageNum = (int)getSigned();
+        rec.addr.offset = (int)getSigned();
+        rec.addr.access = (flags & 1) ? READ_WRITE : READ_ONLY;
+        if (flags & 2) {
+            size_t id = (size_t)getVarint();
+            if (flags & 4) {
+                if (faults.size() <= id) faults.resize(id + 1);
+                faults[id] = getString();
+            }
+            rec.physical_address = -1;
+            rec.fault = (id < faults.size()) ? faults[id] : "Unknown fault";
+        } else {
+            rec.physical_address = (int)getSigned();
+            rec.fault = "OK";
+        }
+        rec.latency = (int)getSigned();
+        return !file.fail();
+    }
+
+    const std::string& summary() const { return summary_text; }
+
+private:
+    std::ifstream file;
+    std::vector<std::string> faults;
+    std::string summary_text;
+    int last_time = 0;
+
+    uint64_t getVarint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int b = file.get();
+            if (b == std::char_traits<char>::eof()) break;
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        return v;
+    }
+
+    int64_t getSigned() {
+        uint64_t v = getVarint();
+        return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    }
+
+    std::string getString() {
+        std::string s(getVarint(), '\0');
+        file.read(s.data(), (std::streamsize)s.size());
+        return s;
+    }
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+// xoshiro256** seeded through splitmix64. Unlike rand() it has no global
+// state or lock, so every simulation owns its stream and a given seed
+// replays bit-for-bit.
+
+#include <cstdint>
+
+class Rng {
+public:
+    using result_type = uint64_t;
+
+    explicit Rng(uint64_t seed = 1) {
+        for (auto& word : s) {
+            word = splitmix64(seed);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound) by multiply-shift (Lemire); the bias is below
+    // 2^-32 for the bounds used here.
+    uint32_t uniform(uint32_t bound) {
+        return (uint32_t)(((*this)() >> 32) * bound >> 32);
+    }
+
+    double uniformReal() {
+        return ((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Independent stream derived from this one
+    Rng split() {
+        return Rng((*this)());
+    }
+
+    // Raw generator state, for checkpointing a simulation mid-stream
+    static const int STATE_WORDS = 4;
+    void saveState(uint64_t out[STATE_WORDS]) const {
+        for (int i = 0; i < STATE_WORDS; ++i) out[i] = s[i];
+    }
+    void restoreState(const uint64_t in[STATE_WORDS]) {
+        for (int i = 0; i < STATE_WORDS; ++i) s[i] = in[i];
+    }
+
+private:
+    uint64_t s[STATE_WORDS];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static uint64_t splitmix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+// Command line of the interactive parts. Everything else they ask for at
+// the prompts; the seed has to come first so a session can be replayed,
+// and --capture records what it translated as a trace for --trace.
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "vmsim.hpp"
+#include "trace.hpp"
+
+struct SessionOptions {
+    uint64_t seed = 0;        // --seed N; defaults to the clock
+    std::string capture_path; // --capture PATH; empty: none
+};
+
+// A decimal uint64_t and nothing else
+inline bool parseSeed(const char* text, uint64_t& out) {
+    const char* end = text + std::strlen(text);
+    auto [next, ec] = std::from_chars(text, end, out);
+    return ec == std::errc() && next == end && next != text;
+}
+
+// Fills opt from argv; on an unknown or malformed option prints the usage
+// line and returns false
+inline bool parseSessionArgs(int argc, char** argv, SessionOptions& opt) {
+    opt.seed = std::chrono::system_clock::now().time_since_epoch().count();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue && parseSeed(argv[i + 1], opt.seed)) {
+            i++;
+            continue;
+        }
+        if (arg == "--capture" && hasValue) {
+            opt.capture_path = argv[++i];
+            continue;
+        }
+        std::cout << "Usage: " << argv[0] << " [--seed N] [--capture PATH]\n";
+        return false;
+    }
+    return true;
+}
+
+// Starts recording what st translates to a trace sized for its layout;
+// nothing for an empty path
+inline void startCapture(const std::string& path, SegmentTable& st, std::unique_ptr<Trace>& capture) {
+    if (path.empty()) return;
+    capture = std::make_unique<Trace>(st);
+    st.capture = capture.get();
+}
+
+// Writes the captured trace to path; false if it could not be written
+inline bool saveCapture(const std::string& path, const std::unique_ptr<Trace>& capture) {
+    if (!capture) return true;
+    if (!capture->saveBinary(path)) {
+        std::cout << "Error: Could not write trace " << path << "\n";
+        return false;
+    }
+    std::cout << "Captured " << capture->size() << " accesses to " << path << "\n";
+    return true;
+}
+
+#endif
@@ -0,0 +1,336 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+// Binary checkpoint of a whole SegmentTable: segments, directories, page
+// tables, frame allocation and FIFO order, the clock, readahead streams and
+// the latency RNG. Restoring one skips the warm-up replay, and the
+// simulation then continues exactly as the saved one would have.
+//
+// The file is a fixed header followed by flat arrays, each starting on an
+// 8-byte boundary, so restoreSnapshot() maps it and copies the page arrays
+// straight into the tables. Files are tied to the build that wrote them
+// (native byte order, sizeof(Page) checked).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vmsim.hpp"
+
+static_assert(std::is_trivially_copyable_v<Page>, "snapshots copy Page arrays as raw bytes");
+static_assert(std::is_trivially_copyable_v<FaultStream>, "snapshots copy FaultStream as raw bytes");
+static_assert(sizeof(Protection) == sizeof(int32_t), "snapshots store Protection as int32_t");
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t page_record_size; // sizeof(Page) in the writing build
+    int32_t num_frames;
+    int32_t page_size;
+    int32_t algo;
+    int32_t time;
+    int32_t wasted_prefetches;
+    int32_t readahead_enabled;
+    int32_t initial_window;
+    int32_t max_window;
+    int32_t reserved;
+    int64_t demand_faults;
+    int64_t issued;
+    int64_t useful;
+    int64_t cow_faults;
+    uint64_t rng[Rng::STATE_WORDS];
+    uint64_t num_segments;
+    uint64_t num_directories;
+    uint64_t num_tables;
+    uint64_t num_pages;
+    uint64_t fifo_length;
+    uint64_t num_streams;
+    uint64_t file_size;
+};
+
+struct SnapshotSegment {
+    int32_t base;
+    int32_t limit;
+    int32_t protection;
+};
+
+struct SnapshotDirectory {
+    int32_t segment;
+    int32_t page_table_size;
+    int32_t num_tables; // the next num_tables table records belong here
+};
+
+struct SnapshotTable {
+    int32_t index;
+    int32_t page_size;
+    int32_t num_pages; // the next num_pages page records belong here
+};
+
+struct SnapshotStream {
+    int32_t segment;
+    int32_t directory;
+    FaultStream state;
+};
+
+namespace snapshot_detail {
+
+inline const char MAGIC[4] = {'V', 'M', 'S', 'S'};
+const uint32_t VERSION = 3;
+
+inline size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+template <typename T>
+void append(std::vector<char>& out, const T* items, size_t count) {
+    out.resize(align8(out.size()));
+    const char* bytes = (const char*)items;
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+// The raw record holds only values a Page can take; read as bytes, since
+// loading a bool that is neither 0 nor 1 is undefined
+inline bool validPage(const Page* page, int numFrames) {
+    const unsigned char* raw = (const unsigned char*)page;
+    for (size_t flag : {offsetof(Page, present), offsetof(Page, cow), offsetof(Page, prefetched),
+                        offsetof(Page, dirty)}) {
+        if (raw[flag] > 1) return false;
+    }
+    int32_t protection;
+    std::memcpy(&protection, raw + offsetof(Page, protection), sizeof(protection));
+    if (protection != READ_ONLY && protection != READ_WRITE) return false;
+    return !page->present || (page->frame_number >= 0 && page->frame_number < numFrames);
+}
+
+// Physical addresses are ints: frame * page_size + offset must not overflow
+inline bool fitsAddresses(int numFrames, int pageSize) {
+    return pageSize > 0 && (int64_t)numFrames * pageSize <= INT32_MAX;
+}
+
+// Bounds-checked walk over the mapped file
+class Cursor {
+public:
+    Cursor(const char* data, size_t size) : base(data), end(size) {}
+
+    template <typename T>
+    const T* take(size_t count) {
+        pos = align8(pos);
+        if (count > (end - pos) / sizeof(T)) return nullptr;
+        const T* p = (const T*)(base + pos);
+        pos += count * sizeof(T);
+        return p;
+    }
+
+private:
+    const char* base;
+    size_t end;
+    size_t pos = 0;
+};
+
+}
+
+// Writes st to filename; false if the file cannot be written
+inline bool saveSnapshot(SegmentTable& st, const std::string& filename) {
+    using namespace snapshot_detail;
+    PhysicalMemory& mem = *st.physMem;
+
+    std::vector<SnapshotSegment> segments;
+    for (const Segment& s : st.segments) {
+        segments.push_back({s.base_address, s.limit, (int32_t)s.protection});
+    }
+
+    std::vector<SnapshotDirectory> dirs;
+    std::vector<SnapshotTable> tables;
+    size_t numPages = 0;
+    for (auto& [segId, dir] : st.segment_directories) {
+        dirs.push_back({segId, dir.page_table_size, (int32_t)dir.page_tables.size()});
+        for (auto& [index, pt] : dir.page_tables) {
+            tables.push_back({index, pt.page_size, (int32_t)pt.pages.size()});
+            numPages += pt.pages.size();
+        }
+    }
+
+    std::vector<uint8_t> freeFrames(mem.free_frames.begin(), mem.free_frames.end());
+
+    std::vector<int> order = mem.fifoOrder();
+    std::vector<int32_t> fifo(order.begin(), order.end());
+
+    std::vector<SnapshotStream> streams;
+    for (auto& [key, s] : st.readahead.streams) {
+        streams.push_back({key.first, key.second, s});
+    }
+
+    SnapshotHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, MAGIC, 4);
+    h.version = VERSION;
+    h.page_record_size = sizeof(Page);
+    h.num_frames = mem.num_frames;
+    h.page_size = st.page_size;
+    h.algo = mem.algo;
+    h.time = mem.time;
+    h.wasted_prefetches = mem.wasted_prefetches;
+    h.readahead_enabled = st.readahead.enabled;
+    h.initial_window = st.readahead.initial_window;
+    h.max_window = st.readahead.max_window;
+    h.demand_faults = st.readahead.demand_faults;
+    h.issued = st.readahead.issued;
+    h.useful = st.readahead.useful;
+    h.cow_faults = st.cow_faults;
+    st.rng.saveState(h.rng);
+    h.num_segments = segments.size();
+    h.num_directories = dirs.size();
+    h.num_tables = tables.size();
+    h.num_pages = numPages;
+    h.fifo_length = fifo.size();
+    h.num_streams = streams.size();
+
+    std::vector<char> out;
+    append(out, &h, 1);
+    append(out, segments.data(), segments.size());
+    append(out, dirs.data(), dirs.size());
+    append(out, tables.data(), tables.size());
+    out.resize(align8(out.size()));
+    for (auto& [segId, dir] : st.segment_directories) {
+        for (auto& [index, pt] : dir.page_tables) {
+            const char* bytes = (const char*)pt.pages.data();
+            out.insert(out.end(), bytes, bytes + pt.pages.size() * sizeof(Page));
+        }
+    }
+    append(out, freeFrames.data(), freeFrames.size());
+    append(out, fifo.data(), fifo.size());
+    append(out, streams.data(), streams.size());
+
+    uint64_t size = out.size();
+    std::memcpy(out.data() + offsetof(SnapshotHeader, file_size), &size, sizeof(size));
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+    file.write(out.data(), (std::streamsize)out.size());
+    return (bool)file;
+}
+
+// Replaces everything in st with the snapshot in filename. Returns false,
+// leaving st untouched, if the file is missing, truncated, inconsistent or
+// was written by an incompatible build, or if st shares its memory with
+// other address spaces (a snapshot brings its own).
+inline bool restoreSnapshot(SegmentTable& st, const std::string& filename) {
+    using namespace snapshot_detail;
+    if (!st.owns_memory) return false;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)sb.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    struct Unmap {
+        void* p;
+        size_t n;
+        ~Unmap() { munmap(p, n); }
+    } unmap{map, size};
+
+    Cursor in((const char*)map, size);
+    const SnapshotHeader* h = in.take<SnapshotHeader>(1);
+    if (std::memcmp(h->magic, MAGIC, 4) != 0 || h->version != VERSION
+        || h->page_record_size != sizeof(Page) || h->file_size != size
+        || h->num_frames <= 0 || !fitsAddresses(h->num_frames, h->page_size) || (h->algo != FIFO && h->algo != LRU)) {
+        return false;
+    }
+
+    const SnapshotSegment* segments = in.take<SnapshotSegment>(h->num_segments);
+    const SnapshotDirectory* dirs = in.take<SnapshotDirectory>(h->num_directories);
+    const SnapshotTable* tables = in.take<SnapshotTable>(h->num_tables);
+    const Page* pages = in.take<Page>(h->num_pages);
+    const uint8_t* freeFrames = in.take<uint8_t>(h->num_frames);
+    const int32_t* fifo = in.take<int32_t>(h->fifo_length);
+    const SnapshotStream* streams = in.take<SnapshotStream>(h->num_streams);
+    if (!segments || !dirs || !tables || !pages || !freeFrames || !fifo || !streams) return false;
+
+    // check every count, index and enum before touching st; a duplicate
+    // segment or table would otherwise attach its pages to the first one
+    for (uint64_t i = 0; i < h->num_segments; ++i) {
+        if (segments[i].protection != READ_ONLY && segments[i].protection != READ_WRITE) return false;
+    }
+    uint64_t tablesSeen = 0, pagesSeen = 0;
+    std::set<int32_t> segmentIds;
+    for (uint64_t d = 0; d < h->num_directories; ++d) {
+        if (!segmentIds.insert(dirs[d].segment).second) return false;
+        if (dirs[d].num_tables < 0 || dirs[d].num_tables > (int64_t)(h->num_tables - tablesSeen)) return false;
+        std::set<int32_t> tableIndexes;
+        for (int32_t t = 0; t < dirs[d].num_tables; ++t, ++tablesSeen) {
+            const SnapshotTable& tr = tables[tablesSeen];
+            if (!tableIndexes.insert(tr.index).second || !fitsAddresses(h->num_frames, tr.page_size)) return false;
+            if (tr.num_pages < 0 || tr.num_pages > (int64_t)(h->num_pages - pagesSeen)) return false;
+            pagesSeen += tr.num_pages;
+        }
+    }
+    if (tablesSeen != h->num_tables || pagesSeen != h->num_pages) return false;
+    for (uint64_t i = 0; i < h->num_pages; ++i) {
+        if (!validPage(&pages[i], h->num_frames)) return false;
+    }
+    for (uint64_t i = 0; i < h->fifo_length; ++i) {
+        if (fifo[i] < 0 || fifo[i] >= h->num_frames) return false;
+    }
+
+    st.clearLayout();
+    delete st.physMem; // detaches any backing store; attach it again after restoring
+    st.physMem = new PhysicalMemory(h->num_frames, (ReplacementAlgorithm)h->algo);
+    PhysicalMemory& mem = *st.physMem;
+    mem.time = h->time;
+    mem.wasted_prefetches = h->wasted_prefetches;
+    for (int f = 0; f < h->num_frames; ++f) mem.setFrameFree(f, freeFrames[f] != 0);
+    for (uint64_t i = 0; i < h->fifo_length; ++i) mem.pushFifo(fifo[i]);
+
+    st.page_size = h->page_size;
+    st.cow_faults = h->cow_faults;
+    st.rng.restoreState(h->rng);
+
+    for (uint64_t i = 0; i < h->num_segments; ++i) {
+        st.segments.push_back({segments[i].base, segments[i].limit, (Protection)segments[i].protection});
+    }
+
+    const SnapshotTable* table = tables;
+    const Page* page = pages;
+    for (uint64_t d = 0; d < h->num_directories; ++d) {
+        PageDirectory& dir = st.segment_directories[dirs[d].segment];
+        dir.page_table_size = dirs[d].page_table_size;
+        for (int32_t t = 0; t < dirs[d].num_tables; ++t, ++table) {
+            PageTable& pt = dir.page_tables.try_emplace(table->index, table->page_size,
+                                                        std::span<const Page>(page, table->num_pages)).first->second;
+            for (int p = 0; p < table->num_pages; ++p) {
+                if (page[p].present) mem.mapPage(page[p].frame_number, &pt, p);
+            }
+            page += table->num_pages;
+        }
+    }
+
+    Readahead& ra = st.readahead;
+    ra.enabled = h->readahead_enabled != 0;
+    ra.initial_window = h->initial_window;
+    ra.max_window = h->max_window;
+    ra.demand_faults = h->demand_faults;
+    ra.issued = h->issued;
+    ra.useful = h->useful;
+    ra.streams.clear();
+    for (uint64_t i = 0; i < h->num_streams; ++i) {
+        ra.streams[{streams[i].segment, streams[i].directory}] = streams[i].state;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include <atomic>
+#include <thread>
+
+#include "sweep.hpp"
+#include "replay.hpp"
+
+std::vector<SweepConfig> sweepGrid(const std::vector<ReplacementAlgorithm>& algos,
+                                   const std::vector<int>& frames, const std::vector<int>& pageSizes) {
+    std::vector<SweepConfig> grid;
+    for (ReplacementAlgorithm algo : algos)
+        for (int f : frames)
+            for (int ps : pageSizes)
+                grid.push_back({algo, f, ps});
+    return grid;
+}
+
+static SweepResult runOne(const SegmentTable& layout, const Trace& trace, const SweepConfig& config) {
+    ReplayRun run(layout, config);
+    run.step(trace, trace.size());
+    return run.result();
+}
+
+std::vector<SweepResult> runSweep(const SegmentTable& layout, const Trace& trace,
+                                  const std::vector<SweepConfig>& configs, int numThreads) {
+    if (numThreads <= 0) numThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::min<int>(numThreads, (int)configs.size());
+
+    std::vector<SweepResult> results(configs.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i = next++; i < configs.size(); i = next++) {
+            results[i] = runOne(layout, trace, configs[i]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < numThreads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    return results;
+}
+
+void writeSweepFields(std::ostream& out, const SweepResult& r) {
+    double faultRate = r.translations ? (double)(r.errors + r.page_faults) / r.translations * 100 : 0;
+    out << (r.config.algo == FIFO ? "FIFO" : "LRU") << "," << r.config.num_frames << ","
+        << r.config.page_size << "," << r.translations << "," << r.errors << "," << r.page_faults << ","
+        << faultRate << "," << r.avg_latency << "," << r.p99_latency << "," << r.utilization << ","
+        << r.seconds;
+}
+
+void writeSweepCsv(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << SWEEP_CSV_COLUMNS << "\n";
+    for (const SweepResult& r : results) {
+        writeSweepFields(out, r);
+        out << "\n";
+    }
+}
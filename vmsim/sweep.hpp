@@ -0,0 +1,49 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+// Parameter sweep: replays one trace under every (policy, frames, page size)
+// combination, one independent SegmentTable per run, spread over a pool of
+// threads that share the parsed trace read-only.
+
+#include <ostream>
+#include <vector>
+
+#include "vmsim.hpp"
+#include "trace.hpp"
+
+struct SweepConfig {
+    ReplacementAlgorithm algo;
+    int num_frames;
+    int page_size;
+};
+
+struct SweepResult {
+    SweepConfig config;
+    long translations = 0;
+    long errors = 0;      // translations that returned -1
+    long page_faults = 0; // faults serviced by allocating a frame
+    double avg_latency = 0;
+    uint64_t p99_latency = 0;
+    double utilization = 0;
+    double seconds = 0;   // wall-clock replay time
+};
+
+// Every combination of the three lists, policy-major
+std::vector<SweepConfig> sweepGrid(const std::vector<ReplacementAlgorithm>& algos,
+                                   const std::vector<int>& frames, const std::vector<int>& pageSizes);
+
+// Replays trace once per config on numThreads threads (0: one per core).
+// Each run copies layout's segments, page protections and RNG state, so a
+// row matches a single run with the same seed and settings. Results come
+// back in config order.
+std::vector<SweepResult> runSweep(const SegmentTable& layout, const Trace& trace,
+                                  const std::vector<SweepConfig>& configs, int numThreads);
+
+inline const char* const SWEEP_CSV_COLUMNS =
+    "Policy,Frames,PageSize,Translations,Errors,PageFaults,FaultRate,AvgLatency,P99Latency,Utilization,Seconds";
+
+// One row's SWEEP_CSV_COLUMNS fields, no newline
+void writeSweepFields(std::ostream& out, const SweepResult& r);
+void writeSweepCsv(std::ostream& out, const std::vector<SweepResult>& results);
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+// In-memory address traces stored as structure-of-arrays: one contiguous
+// column per field, each at the narrowest signed width (1, 2 or 4 bytes)
+// that holds its values. Widths start from the segment table's shape and a
+// column widens itself if a trace holds something out of range (e.g. a bad
+// segment number used to provoke faults).
+
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "vmsim.hpp"
+#include "translate_simd.hpp"
+
+inline int widthFor(long maxValue) {
+    if (maxValue <= INT8_MAX) return 1;
+    if (maxValue <= INT16_MAX) return 2;
+    return 4;
+}
+
+class PackedColumn {
+public:
+    int width = 1;
+    std::vector<uint8_t> bytes;
+
+    explicit PackedColumn(int w = 1) : width(w) {}
+
+    size_t size() const { return bytes.size() / width; }
+
+    void reserve(size_t n) { bytes.reserve(n * width); }
+
+    int32_t get(size_t i) const {
+        const uint8_t* p = bytes.data() + i * width;
+        if (width == 1) return (int8_t)*p;
+        if (width == 2) { int16_t v; std::memcpy(&v, p, 2); return v; }
+        int32_t v; std::memcpy(&v, p, 4); return v;
+    }
+
+    void push(int32_t value) {
+        if (!fits(value)) widen(value);
+        size_t at = bytes.size();
+        bytes.resize(at + width);
+        if (width == 1) { int8_t v = (int8_t)value; std::memcpy(&bytes[at], &v, 1); }
+        else if (width == 2) { int16_t v = (int16_t)value; std::memcpy(&bytes[at], &v, 2); }
+        else std::memcpy(&bytes[at], &value, 4);
+    }
+
+    // Widens rows [begin, begin + n) into out
+    void decode(size_t begin, size_t n, int32_t* out) const {
+        const uint8_t* p = bytes.data() + begin * width;
+        if (width == 1) {
+            const int8_t* src = (const int8_t*)p;
+            for (size_t i = 0; i < n; ++i) out[i] = src[i];
+        } else if (width == 2) {
+            for (size_t i = 0; i < n; ++i) { int16_t v; std::memcpy(&v, p + i * 2, 2); out[i] = v; }
+        } else {
+            std::memcpy(out, p, n * 4);
+        }
+    }
+
+private:
+    bool fits(int32_t value) const {
+        if (width == 1) return value >= INT8_MIN && value <= INT8_MAX;
+        if (width == 2) return value >= INT16_MIN && value <= INT16_MAX;
+        return true;
+    }
+
+    void widen(int32_t value) {
+        long magnitude = (value < 0) ? -(long)value : value;
+        PackedColumn wider(std::max(width * 2, widthFor(magnitude)));
+        wider.reserve(bytes.capacity() / width);
+        for (size_t i = 0; i < size(); ++i) wider.push(get(i));
+        *this = std::move(wider);
+    }
+};
+
+// Decoded int32 rows of a trace, in the layout translateColumns() expects
+struct TraceChunk {
+    std::vector<int32_t> seg, dir, page, offset, access;
+    size_t count = 0;
+
+    AddressColumns columns() const {
+        return {{seg.data(), count}, {dir.data(), count}, {page.data(), count},
+                {offset.data(), count}, {access.data(), count}};
+    }
+};
+
+class Trace {
+public:
+    PackedColumn seg, dir, page, offset, access;
+    const char* load_error = nullptr; // why the last load returned false
+
+    Trace() = default;
+
+    // Column widths sized from the segments, directories and tables in st
+    explicit Trace(const SegmentTable& st) {
+        long maxDir = 0, maxPage = 0, maxOffset = st.page_size;
+        for (auto& [id, pd] : st.segment_directories) {
+            maxDir = std::max(maxDir, (long)pd.page_tables.size());
+            for (auto& [idx, pt] : pd.page_tables) {
+                maxPage = std::max(maxPage, (long)pt.pages.size());
+                maxOffset = std::max(maxOffset, (long)pt.page_size);
+            }
+        }
+        seg = PackedColumn(widthFor((long)st.segments.size()));
+        dir = PackedColumn(widthFor(maxDir));
+        page = PackedColumn(widthFor(maxPage));
+        offset = PackedColumn(widthFor(maxOffset));
+        access = PackedColumn(1);
+    }
+
+    size_t size() const { return seg.size(); }
+
+    void reserve(size_t n) {
+        seg.reserve(n); dir.reserve(n); page.reserve(n); offset.reserve(n); access.reserve(n);
+    }
+
+    void push(int segNum, int pageDir, int pageNum, int off, Protection acc) {
+        seg.push(segNum);
+        dir.push(pageDir);
+        page.push(pageNum);
+        offset.push(off);
+        access.push(acc);
+    }
+
+    void push(const LogicalAddress& a) { push(a.segNum, a.pageDir, a.pageNum, a.offset, a.access); }
+
+    void decode(size_t begin, size_t n, TraceChunk& out) const {
+        for (auto* col : {&out.seg, &out.dir, &out.page, &out.offset, &out.access}) {
+            if (col->size() < n) col->resize(n);
+        }
+        seg.decode(begin, n, out.seg.data());
+        dir.decode(begin, n, out.dir.data());
+        page.decode(begin, n, out.page.data());
+        offset.decode(begin, n, out.offset.data());
+        access.decode(begin, n, out.access.data());
+        out.count = n;
+    }
+
+    // batch.txt format: "seg pageDir pageNum offset access[0=R,1=W]" per
+    // line, '#' comments. Malformed lines are reported and skipped.
+    bool loadText(const std::string& filename) {
+        std::ifstream file(filename);
+        if (!file.is_open()) return fail("cannot open file");
+
+        std::string line;
+        int lineNum = 0;
+        while (std::getline(file, line)) {
+            lineNum++;
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            int v[5];
+            const char* p = line.data();
+            const char* end = p + line.size();
+            int parsed = 0;
+            for (; parsed < 5; ++parsed) {
+                while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+                auto [next, ec] = std::from_chars(p, end, v[parsed]);
+                if (ec != std::errc()) break;
+                p = next;
+            }
+
+            if (parsed == 5) {
+                push(v[0], v[1], v[2], v[3], (v[4] == 1) ? READ_WRITE : READ_ONLY);
+            } else {
+                std::cout << "Warning: Skipping malformed line " << lineNum << " in batch file.\n";
+            }
+        }
+        return true;
+    }
+
+    // Binary layout: "VMTR", uint32 version, uint64 count, then per column
+    // one width byte followed by count * width bytes.
+    bool saveBinary(const std::string& filename) const {
+        std::ofstream out(filename, std::ios::binary);
+        if (!out.is_open()) return false;
+        uint32_t version = 1;
+        uint64_t count = size();
+        out.write(MAGIC, 4);
+        out.write((const char*)&version, sizeof(version));
+        out.write((const char*)&count, sizeof(count));
+        for (const PackedColumn* col : {&seg, &dir, &page, &offset, &access}) {
+            uint8_t w = (uint8_t)col->width;
+            out.write((const char*)&w, 1);
+            out.write((const char*)col->bytes.data(), col->bytes.size());
+        }
+        return (bool)out;
+    }
+
+    // The count is checked against the file size before anything is
+    // allocated; on failure the trace is left empty.
+    bool loadBinary(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) return fail("cannot open file");
+        uint64_t remaining = (uint64_t)in.tellg();
+        in.seekg(0);
+        char magic[4];
+        uint32_t version;
+        uint64_t count;
+        const uint64_t headerSize = sizeof(magic) + sizeof(version) + sizeof(count);
+        if (!in.read(magic, 4) || std::memcmp(magic, MAGIC, 4) != 0) return fail("not a binary trace");
+        if (remaining < headerSize) return fail("truncated binary trace");
+        in.read((char*)&version, sizeof(version));
+        in.read((char*)&count, sizeof(count));
+        if (version != 1) return fail("unsupported binary trace version");
+        remaining -= headerSize;
+        for (PackedColumn* col : {&seg, &dir, &page, &offset, &access}) {
+            uint8_t w;
+            if (!in.read((char*)&w, 1) || (w != 1 && w != 2 && w != 4)) return fail("corrupt binary trace");
+            remaining -= 1;
+            if (count > remaining / w) return fail("truncated binary trace");
+            col->width = w;
+            col->bytes.resize(count * w);
+            if (!in.read((char*)col->bytes.data(), col->bytes.size())) return fail("truncated binary trace");
+            remaining -= count * w;
+        }
+        return true;
+    }
+
+    // Binary if the file starts with the trace magic, text otherwise
+    bool load(const std::string& filename) {
+        std::ifstream probe(filename, std::ios::binary);
+        if (!probe.is_open()) return fail("cannot open file");
+        char magic[4] = {};
+        probe.read(magic, 4);
+        probe.close();
+        if (std::memcmp(magic, MAGIC, 4) == 0) return loadBinary(filename);
+        return loadText(filename);
+    }
+
+    static constexpr const char MAGIC[4] = {'V', 'M', 'T', 'R'};
+
+private:
+    bool fail(const char* why) {
+        for (PackedColumn* col : {&seg, &dir, &page, &offset, &access}) col->bytes.clear();
+        load_error = why;
+        return false;
+    }
+};
+
+struct TraceSummary {
+    size_t accesses = 0;
+    size_t writes = 0;
+    size_t distinct_pages = 0;  // footprint in (seg, dir, page) pages
+    size_t sequential = 0;      // same table, same or next page as previous
+    std::map<int, size_t> per_segment;
+};
+
+// Single streaming pass over the columns
+inline TraceSummary analyzeTrace(const Trace& trace) {
+    TraceSummary s;
+    std::set<std::tuple<int, int, int>> pages;
+    TraceChunk chunk;
+    const size_t CHUNK = 4096;
+    int prevSeg = -1, prevDir = -1, prevPage = -1;
+
+    for (size_t i = 0; i < trace.size(); i += CHUNK) {
+        size_t n = std::min(CHUNK, trace.size() - i);
+        trace.decode(i, n, chunk);
+        for (size_t k = 0; k < n; ++k) {
+            int sg = chunk.seg[k], d = chunk.dir[k], p = chunk.page[k];
+            s.accesses++;
+            s.writes += chunk.access[k] == READ_WRITE;
+            s.per_segment[sg]++;
+            pages.insert({sg, d, p});
+            if (sg == prevSeg && d == prevDir && (p == prevPage || p == prevPage + 1)) {
+                s.sequential++;
+            }
+            prevSeg = sg; prevDir = d; prevPage = p;
+        }
+    }
+    s.distinct_pages = pages.size();
+    return s;
+}
+
+inline void printTraceSummary(std::ostream& out, const TraceSummary& s) {
+    out << "Trace Accesses: " << s.accesses << "\n";
+    out << "Distinct Pages Touched: " << s.distinct_pages << "\n";
+    if (s.accesses > 0) {
+        out << "Write Ratio: " << (double)s.writes / s.accesses * 100 << "%\n";
+        out << "Sequential Accesses: " << (double)s.sequential / s.accesses * 100 << "%\n";
+    }
+    for (auto const& [segNum, count] : s.per_segment) {
+        out << "  Segment " << segNum << ": " << count << " accesses\n";
+    }
+}
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef TRANSLATE_SIMD_HPP
+#define TRANSLATE_SIMD_HPP
+
+// Block translation over structure-of-arrays address columns. Each block of
+// eight addresses is validated at once (segment range and protection,
+// directory, page and offset bounds, residency, page protection) lane by
+// lane, or with AVX2 gathers when built with VMSIM_AVX2 and the CPU has
+// them; bench_batch has not shown the gathers beating the scalar lanes, so
+// they are off by default. Resident hits are committed in order; the first
+// lane that is not a clean hit goes through SegmentTable::translate() and
+// the block restarts after it, since a fault may have evicted a page a later
+// lane was about to hit.
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#if defined(VMSIM_AVX2) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VMSIM_HAVE_AVX2_KERNEL 1
+#endif
+
+#include "vmsim.hpp"
+
+struct AddressColumns {
+    std::span<const int32_t> seg;
+    std::span<const int32_t> dir;
+    std::span<const int32_t> page;
+    std::span<const int32_t> offset;
+    std::span<const int32_t> access; // Protection values
+
+    size_t size() const { return seg.size(); }
+};
+
+// Flattened, gather-friendly copy of the segment/directory structure. The
+// Page arrays are referenced, not copied, so residency stays live; rebuild
+// the view after adding segments.
+struct TranslationView {
+    int32_t num_segments = 0;
+    std::vector<int32_t> seg_read_only;
+    std::vector<int32_t> seg_dir_base;  // first table index of the segment
+    std::vector<int32_t> seg_dir_count; // directory indices 0..count-1
+    std::vector<Page*> table_pages;     // entry 0 is an empty placeholder
+    std::vector<int32_t> table_num_pages;
+    std::vector<int32_t> table_page_size;
+
+    explicit TranslationView(SegmentTable& st) {
+        static Page placeholder;
+        table_pages.push_back(&placeholder);
+        table_num_pages.push_back(0);
+        table_page_size.push_back(0);
+
+        num_segments = (int32_t)st.segments.size();
+        for (int s = 0; s < num_segments; ++s) {
+            seg_read_only.push_back(st.segments[s].protection == READ_ONLY);
+            seg_dir_base.push_back((int32_t)table_pages.size());
+
+            auto it = st.segment_directories.find(s);
+            if (it == st.segment_directories.end() || it->second.page_tables.empty()) {
+                seg_dir_count.push_back(0);
+                continue;
+            }
+            int maxDir = it->second.page_tables.rbegin()->first;
+            seg_dir_count.push_back(std::max(maxDir + 1, 0));
+            for (int d = 0; d <= maxDir; ++d) {
+                PageTable* pt = it->second.getPageTable(d);
+                table_pages.push_back(pt ? pt->pages.data() : &placeholder);
+                table_num_pages.push_back(pt ? (int32_t)pt->pages.size() : 0);
+                table_page_size.push_back(pt ? pt->page_size : 0);
+            }
+        }
+    }
+};
+
+// Classifies lanes [0, lanes) of a block: bit k of the result is set when
+// lane k is a resident hit, with its physical address in phys[k] and its
+// table index in table[k].
+inline unsigned classifyBlockScalar(const TranslationView& v, const AddressColumns& in, size_t i,
+                                    size_t lanes, int32_t* phys, int32_t* table) {
+    unsigned mask = 0;
+    for (size_t k = 0; k < lanes; ++k) {
+        int32_t s = in.seg[i + k], d = in.dir[i + k], p = in.page[i + k], o = in.offset[i + k];
+        bool write = in.access[i + k] == READ_WRITE;
+        if (s < 0 || s >= v.num_segments) continue;
+        if (write && v.seg_read_only[s]) continue;
+        if (d < 0 || d >= v.seg_dir_count[s]) continue;
+        int32_t t = v.seg_dir_base[s] + d;
+        if (p < 0 || p >= v.table_num_pages[t]) continue;
+        if (o < 0 || o >= v.table_page_size[t]) continue;
+        const Page& page = v.table_pages[t][p];
+        if (!page.present || (write && (page.protection == READ_ONLY || page.cow))) continue;
+
+        phys[k] = page.frame_number * v.table_page_size[t] + o;
+        table[k] = t;
+        mask |= 1u << k;
+    }
+    return mask;
+}
+
+#ifdef VMSIM_HAVE_AVX2_KERNEL
+
+// Gathers one 32-bit Page field for four lanes from 64-bit Page addresses.
+__attribute__((target("avx2")))
+inline __m128i gatherPageField(__m256i pageAddr, int fieldOffset) {
+    __m256i addr = _mm256_add_epi64(pageAddr, _mm256_set1_epi64x(fieldOffset));
+    return _mm256_i64gather_epi32(static_cast<const int*>(nullptr), addr, 1);
+}
+
+static_assert(offsetof(Page, cow) == offsetof(Page, present) + 1, "one gather reads both flags");
+
+__attribute__((target("avx2")))
+inline unsigned classifyBlockAvx2(const TranslationView& v, const AddressColumns& in, size_t i,
+                                  int32_t* phys, int32_t* table) {
+    if (v.num_segments == 0) return 0;
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+    __m256i s = _mm256_loadu_si256((const __m256i*)(in.seg.data() + i));
+    __m256i d = _mm256_loadu_si256((const __m256i*)(in.dir.data() + i));
+    __m256i p = _mm256_loadu_si256((const __m256i*)(in.page.data() + i));
+    __m256i o = _mm256_loadu_si256((const __m256i*)(in.offset.data() + i));
+    __m256i a = _mm256_loadu_si256((const __m256i*)(in.access.data() + i));
+    __m256i write = _mm256_cmpeq_epi32(a, _mm256_set1_epi32(READ_WRITE));
+
+    // segment range; invalid lanes are clamped to index 0 for the gathers
+    __m256i valid = _mm256_and_si256(_mm256_cmpgt_epi32(s, minusOne),
+                                     _mm256_cmpgt_epi32(_mm256_set1_epi32(v.num_segments), s));
+    s = _mm256_and_si256(s, valid);
+
+    __m256i segRO = _mm256_i32gather_epi32(v.seg_read_only.data(), s, 4);
+    __m256i dirCount = _mm256_i32gather_epi32(v.seg_dir_count.data(), s, 4);
+    __m256i dirBase = _mm256_i32gather_epi32(v.seg_dir_base.data(), s, 4);
+    valid = _mm256_andnot_si256(_mm256_and_si256(write, _mm256_cmpgt_epi32(segRO, _mm256_setzero_si256())), valid);
+    valid = _mm256_and_si256(valid, _mm256_and_si256(_mm256_cmpgt_epi32(d, minusOne),
+                                                     _mm256_cmpgt_epi32(dirCount, d)));
+
+    __m256i t = _mm256_and_si256(_mm256_add_epi32(dirBase, d), valid);
+    __m256i numPages = _mm256_i32gather_epi32(v.table_num_pages.data(), t, 4);
+    __m256i pageSize = _mm256_i32gather_epi32(v.table_page_size.data(), t, 4);
+    valid = _mm256_and_si256(valid, _mm256_and_si256(_mm256_cmpgt_epi32(p, minusOne),
+                                                     _mm256_cmpgt_epi32(numPages, p)));
+    valid = _mm256_and_si256(valid, _mm256_and_si256(_mm256_cmpgt_epi32(o, minusOne),
+                                                     _mm256_cmpgt_epi32(pageSize, o)));
+    p = _mm256_and_si256(p, valid);
+
+    // Page addresses: table base pointer + page index * sizeof(Page)
+    const long long* bases = reinterpret_cast<const long long*>(v.table_pages.data());
+    const __m256i pageBytes = _mm256_set1_epi64x(sizeof(Page));
+    __m256i addrLo = _mm256_add_epi64(_mm256_i32gather_epi64(bases, _mm256_castsi256_si128(t), 8),
+                                      _mm256_mul_epu32(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(p)), pageBytes));
+    __m256i addrHi = _mm256_add_epi64(_mm256_i32gather_epi64(bases, _mm256_extracti128_si256(t, 1), 8),
+                                      _mm256_mul_epu32(_mm256_cvtepi32_epi64(_mm256_extracti128_si256(p, 1)), pageBytes));
+
+    __m256i frame = _mm256_set_m128i(gatherPageField(addrHi, offsetof(Page, frame_number)),
+                                     gatherPageField(addrLo, offsetof(Page, frame_number)));
+    __m256i present = _mm256_set_m128i(gatherPageField(addrHi, offsetof(Page, present)),
+                                       gatherPageField(addrLo, offsetof(Page, present)));
+    __m256i prot = _mm256_set_m128i(gatherPageField(addrHi, offsetof(Page, protection)),
+                                    gatherPageField(addrLo, offsetof(Page, protection)));
+
+    // present and cow are the first two bytes of the gathered word; the
+    // other two are padding. A write to a cow page leaves the fast path.
+    __m256i cow = _mm256_and_si256(present, _mm256_set1_epi32(0xFF00));
+    present = _mm256_and_si256(present, _mm256_set1_epi32(0xFF));
+    valid = _mm256_andnot_si256(_mm256_cmpeq_epi32(present, _mm256_setzero_si256()), valid);
+    __m256i pageRO = _mm256_cmpeq_epi32(prot, _mm256_set1_epi32(READ_ONLY));
+    __m256i pageCow = _mm256_andnot_si256(_mm256_cmpeq_epi32(cow, _mm256_setzero_si256()), write);
+    valid = _mm256_andnot_si256(_mm256_or_si256(_mm256_and_si256(write, pageRO), pageCow), valid);
+
+    __m256i addr = _mm256_add_epi32(_mm256_mullo_epi32(frame, pageSize), o);
+    _mm256_storeu_si256((__m256i*)phys, addr);
+    _mm256_storeu_si256((__m256i*)table, t);
+    return (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(valid));
+}
+
+#endif
+
+inline bool avx2Available() {
+#ifdef VMSIM_HAVE_AVX2_KERNEL
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+// Translates every address in the columns into out[], in order, with the same
+// results and side effects as per-address translate() calls.
+inline void translateColumns(SegmentTable& st, const TranslationView& v, const AddressColumns& in,
+                             std::span<TranslationResult> out, bool allowSimd = true) {
+    VMSIM_PHASE(PHASE_BATCH);
+    size_t n = std::min(in.size(), out.size());
+    bool simd = allowSimd && avx2Available();
+    int32_t phys[8], table[8];
+
+    size_t i = 0;
+    while (i < n) {
+        size_t lanes = std::min<size_t>(8, n - i);
+        unsigned mask;
+#ifdef VMSIM_HAVE_AVX2_KERNEL
+        if (simd && lanes == 8) {
+            mask = classifyBlockAvx2(v, in, i, phys, table);
+        } else
+#endif
+        {
+            mask = classifyBlockScalar(v, in, i, lanes, phys, table);
+        }
+
+        size_t k = 0;
+        for (; k < lanes; ++k) {
+            size_t idx = i + k;
+            TranslationResult& r = out[idx];
+            if (!(mask & (1u << k))) {
+                r.physical_address = st.translate(in.seg[idx], in.dir[idx], in.page[idx], in.offset[idx],
+                                                  (Protection)in.access[idx], r.latency, r.fault);
+                k++;
+                break;
+            }
+
+            uint64_t start = st.latency_profile ? wallNanos() : 0;
+            Page& page = v.table_pages[table[k]][in.page[idx]];
+            st.physMem->time++;
+            r.latency = 1 + st.rng.uniform(5);
+            r.fault = "OK";
+            page.last_access_time = st.physMem->time;
+            st.physMem->markChanged(page.frame_number);
+            if (in.access[idx] == READ_WRITE) st.physMem->recordWrite(page, in.offset[idx]);
+            if (page.prefetched) {
+                page.prefetched = false;
+                st.readahead.onPrefetchHit();
+            }
+            r.physical_address = phys[k];
+            if (st.latency_profile) st.latency_profile->record(FAULT_NONE, r.latency, wallNanos() - start);
+        }
+        i += k;
+    }
+}
+
+#endif
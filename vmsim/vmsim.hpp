@@ -0,0 +1,878 @@
+#ifndef VMSIM_HPP
+#define VMSIM_HPP
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <memory_resource>
+#include <queue>
+#include <string>
+#include <span>
+#include <iomanip>
+#include <climits>
+#include <algorithm>
+
+#include "rng.hpp"
+#include "instrument.hpp"
+#include "histogram.hpp"
+#include "backing_store.hpp"
+
+enum ReplacementAlgorithm { FIFO, LRU };
+
+enum Protection { READ_ONLY, READ_WRITE };
+
+struct Page {
+    int frame_number = -1;
+    bool present = false;
+    bool cow = false;        // frame shared copy-on-write: a write copies it first
+    Protection protection = READ_WRITE;
+    int last_access_time = 0;
+    bool prefetched = false; // mapped by readahead, not yet touched
+    bool dirty = false;      // with a backing store: frame differs from the swap slot
+};
+
+struct Segment {
+    int base_address;
+    int limit;
+    Protection protection;
+};
+
+struct LogicalAddress {
+    int segNum;
+    int pageDir;
+    int pageNum;
+    int offset;
+    Protection access;
+};
+
+struct TranslationResult {
+    int physical_address = -1; // -1 on any fault/error
+    int latency = 0;
+    const char* fault = "OK";
+};
+
+class PageTable; 
+struct LiveMetrics;
+class Trace;
+
+// per-access diagnostics (faults, allocations, evictions); off for benchmarks
+inline bool verbose = true;
+
+// per-fault-type latency percentiles from the stress test and batch replay;
+// they cost two clock reads per translation, so only on request unless
+// instrumented
+#ifdef VMSIM_INSTRUMENT
+inline bool latency_report = true;
+#else
+inline bool latency_report = false;
+#endif
+
+// Page tables and directories are allocator-aware: inside a SegmentTable's
+// maps they are built in place and take their storage from its arena.
+// They are move-only so no table is copied by accident.
+
+// --- PageTable must be a complete type before PageDirectory uses it by value ---
+class PageTable {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    std::pmr::vector<Page> pages;
+    int page_size;
+
+    PageTable(int numPages, int pSize, Rng& rng, const allocator_type& alloc = {})
+        : pages(alloc), page_size(pSize) {
+        pages.resize(numPages);
+        for (auto& p : pages) {
+            p.present = false;
+            p.protection = rng.uniform(2) ? READ_WRITE : READ_ONLY;
+            p.frame_number = -1;
+            p.last_access_time = 0;
+        }
+    }
+    
+    explicit PageTable(const allocator_type& alloc = {}) : pages(alloc), page_size(1000) {
+        pages.resize(100);
+        for (auto& p : pages) {
+            p.present = false;
+            p.protection = READ_WRITE;
+            p.frame_number = -1;
+            p.last_access_time = 0;
+        }
+    }
+
+    // A copy of another table's pages
+    PageTable(int pSize, std::span<const Page> from, const allocator_type& alloc = {})
+        : pages(from.begin(), from.end(), alloc), page_size(pSize) {}
+
+    PageTable(PageTable&&) = default;
+    PageTable& operator=(PageTable&&) = default;
+    PageTable(const PageTable&) = delete;
+    PageTable& operator=(const PageTable&) = delete;
+
+    int getFrameNumber(int pageNum, int time, Protection accessType, const char*& fault) {
+        VMSIM_PHASE(PHASE_PAGE_WALK);
+        if (pageNum < 0 || pageNum >= (int)pages.size()) {
+            fault = "Page Fault: Invalid page number";
+            if (verbose) std::cout << fault << " " << pageNum << "\n";
+            return -1;
+        }
+
+        if (accessType == READ_WRITE && pages[pageNum].protection == READ_ONLY) {
+            fault = "Protection Violation: Cannot write to read-only page";
+            if (verbose) std::cout << fault << "\n";
+            return -1;
+        }
+
+        if (!pages[pageNum].present) {
+            fault = "Page Fault: Page not in memory";
+            if (verbose) std::cout << fault << " " << pageNum << "\n";
+            return -2;
+        }
+
+        pages[pageNum].last_access_time = time;
+        return pages[pageNum].frame_number;
+    }
+
+    void setFrame(int pageNum, int frame, Protection prot, int time) {
+        VMSIM_PHASE(PHASE_SET_FRAME);
+        if (pageNum >= 0 && pageNum < (int)pages.size()) {
+            pages[pageNum].frame_number = frame;
+            pages[pageNum].present = true;
+            pages[pageNum].protection = prot;
+            pages[pageNum].last_access_time = time;
+            pages[pageNum].prefetched = false;
+            pages[pageNum].cow = false;
+            pages[pageNum].dirty = true; // until swapIn() says it came from the slot
+        }
+    }
+
+    void invalidatePage(int pageNum) {
+        if (pageNum >= 0 && pageNum < (int)pages.size()) {
+            pages[pageNum].frame_number = -1;
+            pages[pageNum].present = false;
+            pages[pageNum].prefetched = false;
+            pages[pageNum].cow = false;
+        }
+    }
+};
+
+class PageDirectory {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    std::pmr::map<int, PageTable> page_tables; 
+    int page_table_size; 
+
+    PageDirectory(int defaultPageTableSize, const allocator_type& alloc = {})
+        : page_tables(alloc), page_table_size(defaultPageTableSize) {}
+
+    explicit PageDirectory(const allocator_type& alloc = {}) : PageDirectory(100, alloc) {}
+
+    PageDirectory(PageDirectory&&) = default;
+    PageDirectory& operator=(PageDirectory&&) = default;
+    PageDirectory(const PageDirectory&) = delete;
+    PageDirectory& operator=(const PageDirectory&) = delete;
+
+    PageTable* getPageTable(int pageDirIndex) {
+        if (page_tables.find(pageDirIndex) == page_tables.end()) {
+            return nullptr;
+        }
+        return &page_tables[pageDirIndex];
+    }
+    
+    void addPageTable(int pageDirIndex, int numPages, int pageSize, Rng& rng) {
+         page_tables.erase(pageDirIndex);
+         page_tables.try_emplace(pageDirIndex, numPages, pageSize, rng);
+    }
+};
+
+
+// One page mapped to a frame
+struct PageOwner {
+    PageTable* table;
+    int page;
+};
+
+class PhysicalMemory {
+public:
+    int num_frames;
+    std::vector<bool> free_frames;
+    int time = 0;
+    ReplacementAlgorithm algo; 
+    int wasted_prefetches = 0; // prefetched pages evicted before first use
+    // reverse map: frame -> every page mapped to it; the frame's reference
+    // count is the number of owners. Owned per memory so separate
+    // simulations can run on separate threads.
+    std::map<int, std::vector<PageOwner>> frame_to_page_map;
+    BackingStore* store = nullptr; // optional swap device for frame contents
+    int used_frames = 0;
+    long evictions = 0; // frames taken from resident pages
+
+    PhysicalMemory(int frames, ReplacementAlgorithm algorithm) 
+        : num_frames(frames), algo(algorithm) {
+        free_frames.resize(frames, true);
+        frame_changed.resize(frames, 0);
+        frame_generation.resize(frames, 0);
+    }
+
+    int allocateFrame() {
+        VMSIM_PHASE(PHASE_ALLOCATE);
+        // try free frame first
+        for (int i = 0; i < num_frames && used_frames < num_frames; ++i) {
+            if (free_frames[i]) {
+                setFrameFree(i, false);
+                if (algo == FIFO) {
+                    pushFifo(i);
+                }
+                if (verbose) std::cout << "-> Allocated free frame " << i << "\n";
+                return i;
+            }
+        }
+
+        if (verbose) std::cout << "-> No free frames. Running page replacement...\n";
+        int victimFrame = -1;
+
+        if (algo == FIFO) {
+            // skip entries left behind by frames freed since they queued
+            while (!fifo_queue.empty() && !liveFifo(fifo_queue.front())) fifo_queue.pop();
+            if (fifo_queue.empty()) return -1; 
+            victimFrame = fifo_queue.front().frame;
+            fifo_queue.pop();
+            fifo_queue.push({victimFrame, frame_generation[victimFrame]});
+            if (verbose) std::cout << "-> FIFO victim: frame " << victimFrame << "\n";
+
+        } else { 
+            int minTime = INT_MAX;
+            for(auto const& [frame, owners] : frame_to_page_map) {
+                // a shared frame is as recent as its most recent user
+                int lastAccess = INT_MIN;
+                for (const PageOwner& o : owners) {
+                    lastAccess = std::max(lastAccess, o.table->pages[o.page].last_access_time);
+                }
+                if (lastAccess < minTime) {
+                    minTime = lastAccess;
+                    victimFrame = frame;
+                }
+            }
+            if (verbose) std::cout << "-> LRU victim: frame " << victimFrame << "\n";
+        }
+
+        if (victimFrame != -1) {
+            auto victim = frame_to_page_map.find(victimFrame);
+            if (victim != frame_to_page_map.end()) {
+                // every mapping of a shared frame goes with it
+                for (const PageOwner& o : victim->second) {
+                    if (verbose) std::cout << "-> Evicting page " << o.page
+                              << " from frame " << victimFrame << ".\n";
+
+                    if (o.table->pages[o.page].prefetched) {
+                        wasted_prefetches++;
+                    }
+                    if (store) {
+                        store->swapOut(victimFrame, o.table, o.page, (int)o.table->pages.size(),
+                                       o.table->pages[o.page].dirty);
+                    }
+                    o.table->invalidatePage(o.page);
+                }
+                frame_to_page_map.erase(victim);
+            }
+            // mark victim frame as allocated for immediate reuse
+            if (victimFrame >= 0 && victimFrame < num_frames) {
+                evictions++;
+                setFrameFree(victimFrame, false);
+                markChanged(victimFrame);
+            }
+        }
+        
+        return victimFrame;
+    }
+
+    void freeFrame(int frame) {
+        if (frame >= 0 && frame < num_frames) {
+            setFrameFree(frame, true);
+            markChanged(frame);
+            if(frame_to_page_map.count(frame)) {
+                frame_to_page_map.erase(frame);
+            }
+            // a freed frame rejoins the FIFO order when it is next allocated;
+            // its current entry goes stale and eviction skips it
+            if (algo == FIFO) {
+                frame_generation[frame]++;
+                if (fifo_queue.size() > 2 * (size_t)num_frames) compactFifo();
+            }
+        }
+    }
+
+    // Appends frame to the FIFO order
+    void pushFifo(int frame) {
+        fifo_queue.push({frame, frame_generation[frame]});
+    }
+
+    // Frames in FIFO order, oldest first
+    std::vector<int> fifoOrder() const {
+        std::vector<int> order;
+        for (std::queue<FifoEntry> q = fifo_queue; !q.empty(); q.pop()) {
+            if (liveFifo(q.front())) order.push_back(q.front().frame);
+        }
+        return order;
+    }
+
+    // Adds (pt, pageNum) to the pages mapped to frame
+    void mapPage(int frame, PageTable* pt, int pageNum) {
+        frame_to_page_map[frame].push_back({pt, pageNum});
+        markChanged(frame);
+    }
+
+    // Drops (pt, pageNum) from frame; the last mapping to go frees it
+    void unmapPage(int frame, PageTable* pt, int pageNum) {
+        auto it = frame_to_page_map.find(frame);
+        if (it == frame_to_page_map.end()) return;
+        std::vector<PageOwner>& owners = it->second;
+        for (size_t i = 0; i < owners.size(); ++i) {
+            if (owners[i].table == pt && owners[i].page == pageNum) {
+                owners.erase(owners.begin() + i);
+                break;
+            }
+        }
+        markChanged(frame);
+        if (owners.empty()) freeFrame(frame);
+    }
+
+    int refCount(int frame) const {
+        auto it = frame_to_page_map.find(frame);
+        return it == frame_to_page_map.end() ? 0 : (int)it->second.size();
+    }
+
+    // Mappings served by a frame another page already holds, i.e. the
+    // frames sharing saves
+    int sharedMappings() const {
+        int saved = 0;
+        for (auto const& [frame, owners] : frame_to_page_map) saved += (int)owners.size() - 1;
+        return saved;
+    }
+
+    void setFrameFree(int frame, bool isFree) {
+        if (free_frames[frame] == isFree) return;
+        free_frames[frame] = isFree;
+        used_frames += isFree ? -1 : 1;
+    }
+
+    double utilization() const {
+        return (double)used_frames / num_frames * 100;
+    }
+
+    // Notes that a frame was mapped, unmapped or accessed, for the next
+    // incremental memory map
+    void markChanged(int frame) {
+        if (frame_changed[frame]) return;
+        frame_changed[frame] = 1;
+        changed_frames.push_back(frame);
+    }
+
+    // A write access at offset into page's frame; with a store attached the
+    // frame's bytes change and the page has to be written back on eviction
+    void recordWrite(Page& page, int offset) {
+        if (store == nullptr) return;
+        page.dirty = true;
+        store->writeWord(page.frame_number, offset, (uint64_t)time);
+    }
+
+    // Frames changed since the last call, in the order they first changed
+    void takeChanges(std::vector<int>& out) {
+        out.clear();
+        out.swap(changed_frames);
+        for (int f : out) frame_changed[f] = 0;
+    }
+
+private:
+    std::vector<char> frame_changed;
+    std::vector<int> changed_frames;
+
+    struct FifoEntry {
+        int frame;
+        uint32_t generation; // frame_generation[frame] when queued
+    };
+    std::queue<FifoEntry> fifo_queue;
+    std::vector<uint32_t> frame_generation; // bumped when the frame is freed
+
+    bool liveFifo(const FifoEntry& e) const { return e.generation == frame_generation[e.frame]; }
+
+    // Drops stale entries, so frees without evictions cannot grow the queue
+    void compactFifo() {
+        std::queue<FifoEntry> kept;
+        for (; !fifo_queue.empty(); fifo_queue.pop()) {
+            if (liveFifo(fifo_queue.front())) kept.push(fifo_queue.front());
+        }
+        fifo_queue.swap(kept);
+    }
+};
+
+
+// Fault history for one (segment, directory) page table
+struct FaultStream {
+    int last_fault = -1;   // page number of the previous demand fault
+    int stride = 0;        // page distance between the last two faults
+    int next_expected = -1; // where the next fault lands if the pattern holds
+    int window_start = -1; // first page of the last readahead window
+    int window = 0;        // pages mapped on the last readahead
+};
+
+// Detects sequential/strided demand faults and maps the next pages early.
+class Readahead {
+public:
+    bool enabled = false;
+    int initial_window = 2;
+    int max_window = 16;
+    std::map<std::pair<int, int>, FaultStream> streams;
+
+    long demand_faults = 0;
+    long issued = 0;  // pages mapped speculatively
+    long useful = 0;  // prefetched pages later accessed
+
+    // Records a demand fault and returns how many pages to read ahead
+    // (0 if no pattern yet); stride is set to the page step to use.
+    int onFault(int segNum, int pageDir, int pageNum, int& stride) {
+        demand_faults++;
+        FaultStream& s = streams[{segNum, pageDir}];
+        int delta = pageNum - s.last_fault;
+
+        bool continues = s.last_fault >= 0 && delta != 0
+                         && (delta == s.stride || pageNum == s.next_expected);
+        bool thrashing = s.window > 0 && s.stride != 0
+                         && (pageNum - s.window_start) % s.stride == 0
+                         && (pageNum - s.window_start) / s.stride >= 0
+                         && (pageNum - s.window_start) / s.stride < s.window;
+
+        if (thrashing) {
+            // faulted on a page we already read ahead: it was evicted unused
+            s.window = std::max(s.window / 2, 1);
+        } else if (continues) {
+            s.window = (s.window == 0) ? initial_window : std::min(s.window * 2, max_window);
+        } else {
+            s.stride = (s.last_fault >= 0) ? delta : 0;
+            s.window = 0;
+        }
+
+        s.last_fault = pageNum;
+        stride = s.stride;
+        s.window_start = (s.window > 0) ? pageNum + s.stride : -1;
+        s.next_expected = pageNum + s.stride * (s.window + 1);
+        return s.window;
+    }
+
+    void onPrefetchHit() {
+        useful++;
+    }
+
+    void printMetrics(std::ostream& out, int wasted) const {
+        double accuracy = (issued > 0) ? (double)useful / issued * 100 : 0;
+        double coverage = (useful + demand_faults > 0)
+                          ? (double)useful / (useful + demand_faults) * 100 : 0;
+        out << "Readahead Pages Issued: " << issued << "\n";
+        out << "Readahead Pages Used: " << useful << "\n";
+        out << "Readahead Frames Wasted: " << wasted << "\n";
+        out << "Readahead Accuracy: " << accuracy << "%\n";
+        out << "Readahead Coverage: " << coverage << "%\n";
+        out << "Fault Latency Saved: " << useful * 100 << "\n";
+    }
+};
+
+
+class SegmentTable {
+public:
+    std::vector<Segment> segments;
+    // Backs every directory, page table and Page array below. Bump
+    // allocated; nothing is returned until the table is destroyed or
+    // clearLayout() is called.
+    std::pmr::monotonic_buffer_resource arena{64 * 1024};
+    std::pmr::map<int, PageDirectory> segment_directories{&arena};
+    PhysicalMemory* physMem;
+    int page_size;
+    Readahead readahead;
+    Rng rng; // page protections and simulated latency
+    LatencyProfile* latency_profile = nullptr; // when set, every translation is recorded into it
+    LiveMetrics* live_metrics = nullptr;       // when set, the drivers report each chunk into it
+    Trace* capture = nullptr;                  // when set, the drivers append every address they translate
+    int asid = 0;             // address-space id when sharing memory
+    bool owns_memory = true;  // false: physMem belongs to an AddressSpaceManager
+    long cow_faults = 0;      // writes that copied a shared frame
+
+    SegmentTable(int numFrames, int pSize, ReplacementAlgorithm algo, uint64_t seed = 1) 
+        : page_size(pSize), rng(seed) {
+        physMem = new PhysicalMemory(numFrames, algo);
+    }
+
+    // An address space drawing frames from memory shared with other tables
+    SegmentTable(PhysicalMemory* shared, int pSize, int id, uint64_t seed = 1)
+        : physMem(shared), page_size(pSize), rng(seed), asid(id), owns_memory(false) {}
+    
+    ~SegmentTable() {
+        releaseSwapSlots();
+        if (owns_memory) {
+            delete physMem; 
+            return;
+        }
+        // hand our resident frames back to the shared pool, keeping the
+        // ones other address spaces still map
+        for (auto& [id, dir] : segment_directories) {
+            for (auto& [idx, pt] : dir.page_tables) {
+                for (int p = 0; p < (int)pt.pages.size(); ++p) {
+                    if (pt.pages[p].present) physMem->unmapPage(pt.pages[p].frame_number, &pt, p);
+                }
+            }
+        }
+    }
+
+    SegmentTable(const SegmentTable&) = delete;
+    SegmentTable& operator=(const SegmentTable&) = delete;
+
+    void addSegment(int id, int base, int limit, Protection prot, int dirSize, int tableSize) {
+        segments.push_back({base, limit, prot});
+        segment_directories.erase(id);
+        PageDirectory& dir = segment_directories.try_emplace(id, tableSize).first->second;
+        for(int i=0; i < dirSize; ++i) {
+             dir.addPageTable(i, tableSize, page_size, rng);
+        }
+    }
+
+    // Drops every segment and page table and releases the arena in one go.
+    // Pages still resident keep their frames; callers reset memory too.
+    void clearLayout() {
+        releaseSwapSlots();
+        segments.clear();
+        segment_directories.clear();
+        arena.release();
+    }
+
+    int translateAddress(int segNum, int pageDir, int pageNum, int offset, Protection accessType, int& latency, std::string& fault) {
+        const char* msg;
+        int addr = translate(segNum, pageDir, pageNum, offset, accessType, latency, msg);
+        fault = msg;
+        return addr;
+    }
+
+    int translateAddress(int segNum, int pageDir, int pageNum, int offset, Protection accessType, int& latency) {
+        const char* fault;
+        return translate(segNum, pageDir, pageNum, offset, accessType, latency, fault);
+    }
+
+    int translate(int segNum, int pageDir, int pageNum, int offset, Protection accessType, int& latency, const char*& fault) {
+        if (latency_profile == nullptr) {
+            return doTranslate(segNum, pageDir, pageNum, offset, accessType, latency, fault);
+        }
+        uint64_t start = wallNanos();
+        int addr = doTranslate(segNum, pageDir, pageNum, offset, accessType, latency, fault);
+        latency_profile->record(classifyFault(addr, fault), latency, wallNanos() - start);
+        return addr;
+    }
+
+    int doTranslate(int segNum, int pageDir, int pageNum, int offset, Protection accessType, int& latency, const char*& fault) {
+        VMSIM_PHASE(PHASE_TRANSLATE);
+        physMem->time++;
+        latency = 1 + rng.uniform(5); 
+        fault = "OK";
+
+        if (segNum < 0 || segNum >= (int)segments.size()) {
+            fault = "Segmentation Fault: Invalid segment";
+            if (verbose) std::cout << fault << " " << segNum << "\n";
+            return -1;
+        }
+        Segment& segment = segments[segNum];
+
+        if (accessType == READ_WRITE && segment.protection == READ_ONLY) {
+            fault = "Protection Violation: Cannot write to read-only segment";
+            if (verbose) std::cout << fault << "\n";
+            return -1;
+        }
+
+        if (segment_directories.find(segNum) == segment_directories.end()) {
+             fault = "Segmentation Fault: No page directory for segment";
+             if (verbose) std::cout << fault << " " << segNum << "\n";
+             return -1;
+        }
+        PageDirectory* dir = &segment_directories[segNum];
+
+        PageTable* pt = dir->getPageTable(pageDir);
+        if (pt == nullptr) {
+            fault = "Page Fault: Invalid page directory index";
+            if (verbose) std::cout << fault << " " << pageDir << "\n";
+            return -1;
+        }
+        
+        if (pageNum < 0 || pageNum >= (int)pt->pages.size()) {
+             fault = "Page Fault: Page number exceeds limit";
+             if (verbose) std::cout << fault << " " << pageNum << "\n";
+             return -1;
+        }
+        
+        if (offset < 0 || offset >= pt->page_size) {
+            fault = "Offset Fault: Offset exceeds page size";
+            if (verbose) std::cout << fault << " " << offset << "\n";
+            return -1;
+        }
+
+        int frame = pt->getFrameNumber(pageNum, physMem->time, accessType, fault);
+
+        if (frame == -1) { 
+            return -1;
+        }
+        
+        if (frame == -2) { 
+            if (verbose) std::cout << "-> Handling Page Fault...\n";
+            latency += 100;
+            
+            frame = physMem->allocateFrame(); 
+            if (frame == -1) {
+                fault = "Error: Page replacement failed";
+                if (verbose) std::cout << fault << "\n";
+                return -1;
+            }
+            
+            pt->setFrame(pageNum, frame, segment.protection, physMem->time);
+            physMem->mapPage(frame, pt, pageNum);
+            if (physMem->store) {
+                PageSource from = physMem->store->swapIn(frame, pt, pageNum, (int)pt->pages.size());
+                pt->pages[pageNum].dirty = from != PAGE_FROM_SLOT;
+                if (from == PAGE_FROM_TIER) {
+                    latency -= 100 - BackingStore::TIER_HIT_LATENCY;
+                    if (verbose) std::cout << "-> Decompressed from the compressed tier\n";
+                }
+            }
+
+            if (readahead.enabled) {
+                int stride = 0;
+                int window = readahead.onFault(segNum, pageDir, pageNum, stride);
+                prefetchPages(pt, pageNum, stride, window, segment.protection);
+            }
+        } else {
+            if (pt->pages[pageNum].prefetched) {
+                pt->pages[pageNum].prefetched = false;
+                readahead.onPrefetchHit();
+            }
+            if (accessType == READ_WRITE && pt->pages[pageNum].cow) {
+                frame = copyOnWrite(pt, pageNum, latency, fault);
+                if (frame == -1) return -1;
+            }
+        }
+
+        physMem->markChanged(frame);
+        if (accessType == READ_WRITE) physMem->recordWrite(pt->pages[pageNum], offset);
+        return (frame * pt->page_size) + offset;
+    }
+
+    // Write to a copy-on-write page: the last owner keeps the frame, anyone
+    // else moves to a private copy. Returns the frame to write, or -1.
+    int copyOnWrite(PageTable* pt, int pageNum, int& latency, const char*& fault) {
+        Page& page = pt->pages[pageNum];
+        int shared = page.frame_number;
+        if (physMem->refCount(shared) <= 1) {
+            page.cow = false;
+            return shared;
+        }
+
+        if (verbose) std::cout << "-> Copy-on-write: copying frame " << shared << "\n";
+        latency += 20; // a frame copy, no disk read
+        // leave the shared frame first so replacement cannot pick our own page
+        physMem->unmapPage(shared, pt, pageNum);
+        int frame = physMem->allocateFrame();
+        if (frame == -1) {
+            pt->invalidatePage(pageNum);
+            fault = "Error: Page replacement failed";
+            if (verbose) std::cout << fault << "\n";
+            return -1;
+        }
+        pt->setFrame(pageNum, frame, page.protection, physMem->time);
+        physMem->mapPage(frame, pt, pageNum);
+        // replacement can pick the shared frame itself: the other sharers
+        // were just swapped out with its contents, so the frame already is
+        // our private copy
+        if (physMem->store && frame != shared) physMem->store->copyFrame(shared, frame);
+        cow_faults++;
+        fault = "Copy-on-Write: Page copied";
+        return frame;
+    }
+
+    // Maps the resident pages of src's segment srcSeg into segment segNum
+    // of this table, page for page over the directories both have. With
+    // copyOnWrite both sides keep their protections and the first write
+    // from either copies the frame; otherwise the new mapping is read-only.
+    // src must draw from the same memory with the same page size. Returns
+    // the number of pages mapped.
+    int sharePages(int segNum, SegmentTable& src, int srcSeg, bool copyOnWrite) {
+        if (src.physMem != physMem || src.page_size != page_size) return 0;
+        auto from = src.segment_directories.find(srcSeg);
+        auto to = segment_directories.find(segNum);
+        if (from == src.segment_directories.end() || to == segment_directories.end()) return 0;
+
+        int mapped = 0;
+        for (auto& [idx, spt] : from->second.page_tables) {
+            PageTable* dpt = to->second.getPageTable(idx);
+            if (dpt == nullptr || dpt == &spt) continue;
+            int n = (int)std::min(spt.pages.size(), dpt->pages.size());
+            for (int p = 0; p < n; ++p) {
+                Page& s = spt.pages[p];
+                if (!s.present) continue;
+                Page& d = dpt->pages[p];
+                if (d.present) physMem->unmapPage(d.frame_number, dpt, p);
+
+                dpt->setFrame(p, s.frame_number, copyOnWrite ? d.protection : READ_ONLY, s.last_access_time);
+                physMem->mapPage(s.frame_number, dpt, p);
+                if (copyOnWrite) {
+                    s.cow = true;
+                    d.cow = true;
+                }
+                mapped++;
+            }
+        }
+        return mapped;
+    }
+
+    // Page table for (segNum, pageDir), or nullptr if translate() would reject
+    // the pair before looking at the page. No diagnostics are printed.
+    PageTable* lookupPageTable(int segNum, int pageDir) {
+        if (segNum < 0 || segNum >= (int)segments.size()) return nullptr;
+        auto it = segment_directories.find(segNum);
+        if (it == segment_directories.end()) return nullptr;
+        auto pt = it->second.page_tables.find(pageDir);
+        if (pt == it->second.page_tables.end()) return nullptr;
+        return &pt->second;
+    }
+
+    // Translates addrs[i] into results[i], in order, with the same results
+    // and side effects as calling translate() per address. Consecutive
+    // addresses in the same (segment, directory) share one table lookup and
+    // resident hits are resolved inline; anything else takes translate().
+    void translateBatch(std::span<const LogicalAddress> addrs, std::span<TranslationResult> results) {
+        VMSIM_PHASE(PHASE_BATCH);
+        size_t n = std::min(addrs.size(), results.size());
+        size_t i = 0;
+        while (i < n) {
+            int segNum = addrs[i].segNum;
+            int pageDir = addrs[i].pageDir;
+            PageTable* pt = lookupPageTable(segNum, pageDir);
+            if (pt == nullptr) {
+                TranslationResult& r = results[i];
+                r.physical_address = translate(segNum, pageDir, addrs[i].pageNum, addrs[i].offset,
+                                               addrs[i].access, r.latency, r.fault);
+                i++;
+                continue;
+            }
+
+            bool segReadOnly = segments[segNum].protection == READ_ONLY;
+            int numPages = (int)pt->pages.size();
+            int pSize = pt->page_size;
+
+            for (; i < n && addrs[i].segNum == segNum && addrs[i].pageDir == pageDir; ++i) {
+                const LogicalAddress& a = addrs[i];
+                TranslationResult& r = results[i];
+                bool write = a.access == READ_WRITE;
+                Page* page = (a.pageNum >= 0 && a.pageNum < numPages) ? &pt->pages[a.pageNum] : nullptr;
+                bool hit = page != nullptr && page->present
+                           && a.offset >= 0 && a.offset < pSize
+                           && !(write && (segReadOnly || page->protection == READ_ONLY || page->cow));
+
+                if (hit) {
+                    uint64_t start = latency_profile ? wallNanos() : 0;
+                    physMem->time++;
+                    r.latency = 1 + rng.uniform(5);
+                    r.fault = "OK";
+                    page->last_access_time = physMem->time;
+                    physMem->markChanged(page->frame_number);
+                    if (write) physMem->recordWrite(*page, a.offset);
+                    if (page->prefetched) {
+                        page->prefetched = false;
+                        readahead.onPrefetchHit();
+                    }
+                    r.physical_address = page->frame_number * pSize + a.offset;
+                    if (latency_profile) latency_profile->record(FAULT_NONE, r.latency, wallNanos() - start);
+                    continue;
+                }
+                r.physical_address = translate(a.segNum, a.pageDir, a.pageNum, a.offset,
+                                               a.access, r.latency, r.fault);
+            }
+        }
+    }
+
+    void prefetchPages(PageTable* pt, int pageNum, int stride, int window, Protection prot) {
+        // never let one stream take more than a quarter of memory
+        window = std::min(window, std::max(physMem->num_frames / 4, 1));
+        for (int k = 1; k <= window; ++k) {
+            int p = pageNum + stride * k;
+            if (p < 0 || p >= (int)pt->pages.size()) break;
+            if (pt->pages[p].present) continue;
+
+            int frame = physMem->allocateFrame();
+            if (frame == -1) break;
+            pt->setFrame(p, frame, prot, physMem->time);
+            physMem->mapPage(frame, pt, p);
+            if (physMem->store) {
+                pt->pages[p].dirty = physMem->store->swapIn(frame, pt, p, (int)pt->pages.size()) != PAGE_FROM_SLOT;
+            }
+            pt->pages[p].prefetched = true;
+            readahead.issued++;
+            if (verbose) std::cout << "-> Readahead: page " << p << " into frame " << frame << "\n";
+        }
+    }
+
+    // Swap slots belong to page tables; give them back before the tables go
+    void releaseSwapSlots() {
+        if (physMem->store == nullptr) return;
+        for (auto& [id, dir] : segment_directories) {
+            for (auto& [idx, pt] : dir.page_tables) physMem->store->release(&pt);
+        }
+    }
+
+    void printMemoryMap() {
+        physMem->takeChanges(changed_scratch); // a full map covers them
+        std::cout << "\n--- Memory Map ---\n";
+        std::cout << "Physical Memory Utilization: " << physMem->utilization() << "%\n";
+        std::cout << "Current Time: " << physMem->time << "\n";
+        
+        std::cout << "Frames in Use: \n";
+        for (auto const& [frame, owners] : physMem->frame_to_page_map) {
+             const PageOwner& o = owners.front();
+             std::cout << "  [Frame " << std::setw(2) << frame << "]:"
+                       << " Page " << std::setw(2) << o.page
+                       << " (Last Access: " << o.table->pages[o.page].last_access_time << ")";
+             if (owners.size() > 1) std::cout << " Shared by " << owners.size();
+             std::cout << "\n";
+        }
+        std::cout << "-------------------\n";
+    }
+
+    // Only the frames mapped, evicted, freed or accessed since the last
+    // memory map, at most maxFrames of them; costs O(changes), not O(frames)
+    void printMemoryMapChanges(int maxFrames = 32) {
+        physMem->takeChanges(changed_scratch);
+        std::sort(changed_scratch.begin(), changed_scratch.end());
+        std::cout << "\n--- Memory Map Changes ---\n";
+        std::cout << "Physical Memory Utilization: " << physMem->utilization() << "%\n";
+        std::cout << "Current Time: " << physMem->time << "\n";
+        std::cout << "Frames Changed: " << changed_scratch.size() << " of " << physMem->num_frames << "\n";
+
+        int shown = 0;
+        for (int frame : changed_scratch) {
+            if (shown++ == maxFrames) {
+                std::cout << "  ... " << changed_scratch.size() - maxFrames << " more\n";
+                break;
+            }
+            std::cout << "  [Frame " << std::setw(2) << frame << "]:";
+            auto it = physMem->frame_to_page_map.find(frame);
+            if (it == physMem->frame_to_page_map.end() || it->second.empty()) {
+                std::cout << " free\n";
+                continue;
+            }
+            const PageOwner& o = it->second.front();
+            std::cout << " Page " << std::setw(2) << o.page
+                      << " (Last Access: " << o.table->pages[o.page].last_access_time << ")";
+            if (it->second.size() > 1) std::cout << " Shared by " << it->second.size();
+            std::cout << "\n";
+        }
+        std::cout << "-------------------\n";
+    }
+
+private:
+    std::vector<int> changed_scratch;
+};
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef WORKLOAD_HPP
+#define WORKLOAD_HPP
+
+// Seeded synthetic access patterns, for policy and capacity experiments
+// that uniform random addresses cannot tell apart. Every page of every
+// table in a SegmentTable is numbered 0..N-1 (segment, then directory,
+// then page order) in a PageSpace; a generator picks page numbers and the
+// shared fill loop turns them into addresses with a uniform offset and a
+// write_ratio share of writes.
+//
+//   uniform            every page equally likely
+//   zipf[:THETA]       page of rank k with probability ~ 1/k^THETA (default
+//                      0.99); ranks are shuffled over the pages so the hot
+//                      set is spread across segments
+//   seq, stride:N      a scan that steps N pages at a time and wraps
+//   loop:PAGES         cycles over a window of PAGES consecutive pages;
+//                      larger than memory, it makes LRU miss every time
+//   phased:LEN:A/B/..  runs pattern A for LEN accesses, then B, ..., then
+//                      A again; each phase keeps its own state, and phases
+//                      of the same pattern draw different working sets.
+//                      Phases cannot themselves be phased.
+//
+// Generators fill whole batches through one virtual call, and each owns
+// its Rng, so a seed reproduces the stream exactly.
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "vmsim.hpp"
+
+class PageSpace {
+public:
+    explicit PageSpace(const SegmentTable& st) {
+        for (auto const& [id, dir] : st.segment_directories) {
+            for (auto const& [idx, pt] : dir.page_tables) {
+                for (int p = 0; p < (int)pt.pages.size(); ++p) {
+                    seg.push_back(id);
+                    dir_index.push_back(idx);
+                    page.push_back(p);
+                    page_size.push_back(pt.page_size);
+                }
+            }
+        }
+    }
+
+    size_t size() const { return seg.size(); }
+
+    LogicalAddress at(size_t i, Rng& rng, double writeRatio) const {
+        int offset = (int)rng.uniform((uint32_t)page_size[i]);
+        Protection access = rng.uniformReal() < writeRatio ? READ_WRITE : READ_ONLY;
+        return {seg[i], dir_index[i], page[i], offset, access};
+    }
+
+private:
+    std::vector<int> seg, dir_index, page, page_size;
+};
+
+class Workload {
+public:
+    virtual ~Workload() = default;
+    virtual std::string name() const = 0;
+    // The next out.size() addresses of the stream
+    virtual void generate(std::span<LogicalAddress> out) = 0;
+};
+
+// Generators that choose a page number per access; Derived provides
+// size_t nextPage(), inlined into the fill loop
+template <typename Derived>
+class PageWorkload : public Workload {
+public:
+    PageWorkload(std::shared_ptr<const PageSpace> pages, uint64_t seed, double writeRatio)
+        : space(std::move(pages)), rng(seed), write_ratio(writeRatio) {}
+
+    void generate(std::span<LogicalAddress> out) override {
+        Derived& self = static_cast<Derived&>(*this);
+        for (LogicalAddress& a : out) a = space->at(self.nextPage(), rng, write_ratio);
+    }
+
+protected:
+    std::shared_ptr<const PageSpace> space;
+    Rng rng;
+    double write_ratio;
+};
+
+class UniformWorkload : public PageWorkload<UniformWorkload> {
+public:
+    using PageWorkload::PageWorkload;
+
+    std::string name() const override { return "uniform"; }
+
+    size_t nextPage() { return rng.uniform((uint32_t)space->size()); }
+};
+
+class ZipfWorkload : public PageWorkload<ZipfWorkload> {
+public:
+    ZipfWorkload(std::shared_ptr<const PageSpace> pages, uint64_t seed, double writeRatio, double zipfTheta)
+        : PageWorkload(std::move(pages), seed, writeRatio), theta(zipfTheta) {
+        size_t n = space->size();
+        cdf.resize(n);
+        double sum = 0;
+        for (size_t k = 0; k < n; ++k) {
+            sum += 1.0 / std::pow((double)(k + 1), theta);
+            cdf[k] = sum;
+        }
+        for (double& c : cdf) c /= sum;
+        rank_to_page.resize(n);
+        for (size_t k = 0; k < n; ++k) rank_to_page[k] = (uint32_t)k;
+        for (size_t k = n; k > 1; --k) std::swap(rank_to_page[k - 1], rank_to_page[rng.uniform((uint32_t)k)]);
+    }
+
+    std::string name() const override { return "zipf:" + std::to_string(theta); }
+
+    size_t nextPage() {
+        double u = rng.uniformReal();
+        size_t rank = std::upper_bound(cdf.begin(), cdf.end() - 1, u) - cdf.begin();
+        return rank_to_page[rank];
+    }
+
+private:
+    double theta;
+    std::vector<double> cdf; // P(rank <= k)
+    std::vector<uint32_t> rank_to_page;
+};
+
+class StrideWorkload : public PageWorkload<StrideWorkload> {
+public:
+    StrideWorkload(std::shared_ptr<const PageSpace> pages, uint64_t seed, double writeRatio, int pageStride)
+        : PageWorkload(std::move(pages), seed, writeRatio), stride(pageStride) {
+        position = rng.uniform((uint32_t)space->size());
+    }
+
+    std::string name() const override { return stride == 1 ? "seq" : "stride:" + std::to_string(stride); }
+
+    size_t nextPage() {
+        size_t p = position;
+        position = (position + stride) % space->size();
+        return p;
+    }
+
+private:
+    size_t stride;
+    size_t position;
+};
+
+class LoopWorkload : public PageWorkload<LoopWorkload> {
+public:
+    LoopWorkload(std::shared_ptr<const PageSpace> pages, uint64_t seed, double writeRatio, int loopPages)
+        : PageWorkload(std::move(pages), seed, writeRatio),
+          window(std::min<size_t>(std::max(loopPages, 1), space->size())) {
+        base = rng.uniform((uint32_t)space->size());
+    }
+
+    std::string name() const override { return "loop:" + std::to_string(window); }
+
+    size_t nextPage() {
+        size_t p = (base + step) % space->size();
+        if (++step == window) step = 0;
+        return p;
+    }
+
+private:
+    size_t window;
+    size_t base;
+    size_t step = 0;
+};
+
+class PhasedWorkload : public Workload {
+public:
+    PhasedWorkload(std::vector<std::unique_ptr<Workload>> phaseList, long phaseLength)
+        : phases(std::move(phaseList)), length(std::max(phaseLength, 1L)) {}
+
+    std::string name() const override {
+        std::string s = "phased:" + std::to_string(length) + ":";
+        for (size_t i = 0; i < phases.size(); ++i) {
+            if (i) s += "/";
+            s += phases[i]->name();
+        }
+        return s;
+    }
+
+    void generate(std::span<LogicalAddress> out) override {
+        while (!out.empty()) {
+            size_t n = std::min<size_t>(out.size(), length - done);
+            phases[current]->generate(out.first(n));
+            out = out.subspan(n);
+            if ((done += n) == length) {
+                done = 0;
+                current = (current + 1) % phases.size();
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Workload>> phases;
+    long length;
+    size_t current = 0;
+    long done = 0; // accesses into the current phase
+};
+
+namespace workload_detail {
+
+inline bool parseNumber(const std::string& text, double& out) {
+    if (text.empty()) return false;
+    char* end;
+    out = std::strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+// A whole number in [1, INT_MAX]
+inline bool parseCount(const std::string& text, int& out) {
+    const char* end = text.data() + text.size();
+    auto [next, ec] = std::from_chars(text.data(), end, out);
+    return ec == std::errc() && next == end && out >= 1;
+}
+
+inline std::unique_ptr<Workload> make(const std::string& spec, std::shared_ptr<const PageSpace> pages,
+                                      Rng& seeds, double writeRatio) {
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string arg = colon == std::string::npos ? "" : spec.substr(colon + 1);
+    uint64_t seed = seeds();
+    double v = 0;
+    int n = 0;
+
+    if (kind == "uniform" && arg.empty()) {
+        return std::make_unique<UniformWorkload>(pages, seed, writeRatio);
+    }
+    if (kind == "zipf") {
+        if (arg.empty()) v = 0.99;
+        else if (!parseNumber(arg, v) || !std::isfinite(v) || v < 0) return nullptr;
+        return std::make_unique<ZipfWorkload>(pages, seed, writeRatio, v);
+    }
+    if (kind == "seq" && arg.empty()) {
+        return std::make_unique<StrideWorkload>(pages, seed, writeRatio, 1);
+    }
+    if (kind == "stride" || kind == "loop") {
+        if (!parseCount(arg, n)) return nullptr;
+        if (kind == "stride") return std::make_unique<StrideWorkload>(pages, seed, writeRatio, n);
+        return std::make_unique<LoopWorkload>(pages, seed, writeRatio, n);
+    }
+    if (kind == "phased") {
+        size_t next = arg.find(':');
+        if (next == std::string::npos || !parseCount(arg.substr(0, next), n)) return nullptr;
+        std::vector<std::unique_ptr<Workload>> phases;
+        std::string rest = arg.substr(next + 1);
+        size_t start = 0;
+        while (start <= rest.size()) {
+            size_t slash = rest.find('/', start);
+            if (slash == std::string::npos) slash = rest.size();
+            std::string phaseSpec = rest.substr(start, slash - start);
+            // '/' already separates this level's phases, so a nested list
+            // would be split apart
+            if (phaseSpec.compare(0, 6, "phased") == 0) return nullptr;
+            auto phase = make(phaseSpec, pages, seeds, writeRatio);
+            if (!phase) return nullptr;
+            phases.push_back(std::move(phase));
+            start = slash + 1;
+        }
+        return std::make_unique<PhasedWorkload>(std::move(phases), n);
+    }
+    return nullptr;
+}
+
+}
+
+// Generator for spec (see the top of this file) over st's pages; nullptr
+// if the spec is malformed or st has no pages
+inline std::unique_ptr<Workload> makeWorkload(const std::string& spec, const SegmentTable& st, uint64_t seed,
+                                              double writeRatio = 0.5) {
+    auto pages = std::make_shared<const PageSpace>(st);
+    if (pages->size() == 0) return nullptr;
+    Rng seeds(seed);
+    return workload_detail::make(spec, pages, seeds, writeRatio);
+}
+
+#endif